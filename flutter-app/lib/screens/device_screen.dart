@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:math';
 
 import 'package:flutter/material.dart';
 import 'package:flutter_blue_plus/flutter_blue_plus.dart';
@@ -55,15 +56,28 @@ class _DeviceScreenState extends State<DeviceScreen> {
 
           _lastValueSubscription = _readCharacteristic!.lastValueStream.listen((buf) {
             // Process the value received from the characteristic
-            // Parse the code (solution)
-            code = Combination.fromBuffer(buf.sublist(0, 10));
+            if (buf.isNotEmpty && (buf[0] >> 4) == statusDelta) {
+              if (!applyDelta(buf)) {
+                // A notification was missed, read the whole status again
+                _readCharacteristic!.read();
+                return;
+              }
+            } else if (buf.isNotEmpty && (buf[0] >> 4) == statusV2) {
+              parseStatusV2(buf);
+            } else {
+              // Parse the code (solution)
+              code = Combination.fromBuffer(buf.sublist(0, 10));
+
+              // Parse the tentatives
+              tentatives.clear();
+              for (int i = 0; i < buf[10]; i++) {
+                tentatives.add(Combination.fromBuffer(buf.sublist(11 + i * 10, 21 + i * 10)));
+              }
+            }
 
-            // Parse the tentatives
             roundWon = false;
-            tentatives.clear();
-            for (int i = 0; i < buf[10]; i++) {
-              tentatives.add(Combination.fromBuffer(buf.sublist(11 + i * 10, 21 + i * 10)));
-              if (tentatives[i].cluesCorrect == 4) {
+            for (Combination tentative in tentatives) {
+              if (tentative.cluesCorrect == tentative.slots.length) {
                 roundWon = true;
               }
             }
@@ -91,6 +105,9 @@ class _DeviceScreenState extends State<DeviceScreen> {
             throw Exception("Write characteristic not found");
           }
 
+          // Announce the status formats supported by the application, v1 and v2, with deltas
+          _writeCharacteristic!.write([0x05, 0x83]);
+
           Snackbar.show(ABC.c, "Finding service and characteristics : Success", success: true);
         } catch (e, backtrace) {
           Snackbar.show(ABC.c, prettyException("Discover Services Error:", e), success: false);
@@ -149,6 +166,91 @@ class _DeviceScreenState extends State<DeviceScreen> {
     }
   }
 
+  // Bit-packed status and delta notification, see BLE_STATUS_V2_SIZE and BLE_STATUS_DELTA_SIZE in the firmware
+  static const int statusV2 = 2;
+  static const int statusDelta = 0xD;
+  int slotNb = 4;
+  int colorNb = 6;
+  int? statusSeq;
+  // Trailing section of the v2 status: candidates left, information of the last tentative in 1/256 bit
+  static const int statusV2TrailerSize = 4 + 15;
+  int? candidates;
+  int? infoGained;
+  int? infoExpected;
+
+  int readUint(List<int> buf, int offset, int size) {
+    int value = 0;
+    for (int i = 0; i < size; i++) {
+      value |= buf[offset + i] << (8 * i);
+    }
+    return value;
+  }
+
+  // Parse the candidates and the analytics following the board, and return the offset after them
+  int parseStatusTrailer(List<int> buf, int offset) {
+    if (buf.length < offset + statusV2TrailerSize) {
+      candidates = null;
+      infoGained = null;
+      infoExpected = null;
+      return offset;
+    }
+    candidates = readUint(buf, offset, 4);
+    // Analytics: version, candidates before the tentative, information gained and expected
+    infoGained = readUint(buf, offset + 9, 2);
+    infoExpected = readUint(buf, offset + 11, 2);
+    return offset + statusV2TrailerSize;
+  }
+
+  void parseStatusV2(List<int> buf) {
+    int tryNb = buf[0] & 0x0F;
+    slotNb = buf[1] >> 4;
+    colorNb = buf[1] & 0x0F;
+    int codeNb = pow(colorNb, slotNb).toInt();
+    int cluesNb = (slotNb + 1) * (slotNb + 1);
+    int bitPos = 16;
+
+    int readBits(int width) {
+      int value = 0;
+      for (int i = 0; i < width; i++, bitPos++) {
+        if ((buf[bitPos >> 3] & (1 << (bitPos & 7))) != 0) {
+          value |= 1 << i;
+        }
+      }
+      return value;
+    }
+
+    int secret = readBits(codeNb.bitLength);
+    code = secret < codeNb ? Combination.fromIndex(secret, slotNb, colorNb) : null;
+
+    int tentativeBits = (codeNb * cluesNb - 1).bitLength;
+    tentatives.clear();
+    for (int i = 0; i < tryNb; i++) {
+      int value = readBits(tentativeBits);
+      tentatives.add(Combination.fromIndex(value ~/ cluesNb, slotNb, colorNb, value % cluesNb));
+    }
+
+    // In delta mode the status ends with its sequence number
+    int size = parseStatusTrailer(buf, 2 + (bitPos - 16 + 7) ~/ 8);
+    statusSeq = buf.length > size ? buf[size] : null;
+  }
+
+  // Add the tentative of a delta notification, false if one was missed
+  bool applyDelta(List<int> buf) {
+    int tryNb = buf[0] & 0x0F;
+    int cluesNb = (slotNb + 1) * (slotNb + 1);
+    if (statusSeq == null || buf[1] != ((statusSeq! + 1) & 0xFF) || tryNb != tentatives.length + 1) {
+      return false;
+    }
+
+    // The tentative is followed by the trailing section of the v2 status
+    int tentativeSize = ((pow(colorNb, slotNb).toInt() * cluesNb - 1).bitLength + 7) ~/ 8;
+    int value = readUint(buf, 2, tentativeSize);
+    parseStatusTrailer(buf, 2 + tentativeSize);
+    tentatives.add(Combination.fromIndex(value ~/ cluesNb, slotNb, colorNb, value % cluesNb));
+    statusSeq = buf[1];
+    return true;
+  }
+
   void off() {
     if (_writeCharacteristic != null) {
       _writeCharacteristic!.write([0x01]);
@@ -328,9 +430,26 @@ class _DeviceScreenState extends State<DeviceScreen> {
     );
   }
 
+  // Information in 1/256 bit, 0xFFFF when unknown
+  String formatInfo(int? info) {
+    return info == null || info == 0xFFFF ? "?" : (info / 256).toStringAsFixed(2);
+  }
+
+  Widget buildAnalytics(BuildContext context) {
+    String text = "$candidates possible codes left";
+    if (tentatives.isNotEmpty) {
+      text += ", last try gained ${formatInfo(infoGained)} bits of ${formatInfo(infoExpected)} expected";
+    }
+    return Container(
+      margin: EdgeInsets.only(top: 10.0),
+      child: Text(text, style: TextStyle(fontSize: 15, color: Colors.grey)),
+    );
+  }
+
   Widget buildTentativesList(BuildContext context) {
     return Column(
       children: [
+        if (candidates != null) buildAnalytics(context),
         buildTentativeListHeader(context),
         tentatives.isNotEmpty
             ? ListView.builder(
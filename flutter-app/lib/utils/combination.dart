@@ -1,7 +1,7 @@
 import 'package:flutter/material.dart';
 
 class Combination {
-  List<Color> colors = [Colors.white, Colors.red, Colors.green, Colors.blue, Colors.yellow, Colors.deepPurple];
+  List<Color> colors = [Colors.white, Colors.red, Colors.green, Colors.blue, Colors.yellow, Colors.deepPurple, Colors.cyan, Colors.orange];
   List<Color> slots = [];
   int cluesCorrect = 0;
   int cluesPresent = 0;
@@ -22,6 +22,16 @@ class Combination {
     cluesCorrect = values[9];
   }
 
+  // Combination from its index in the code space, slot 0 being the most significant digit
+  Combination.fromIndex(int index, int slotNb, int colorNb, [int clues = 0]) {
+    for (int i = slotNb - 1; i >= 0; i--) {
+      slots.insert(0, colors[index % colorNb]);
+      index ~/= colorNb;
+    }
+    cluesCorrect = clues ~/ (slotNb + 1);
+    cluesPresent = clues % (slotNb + 1);
+  }
+
   List<int> toBuffer() {
     List<int> list = [];
     for (Color color in slots) {
@@ -0,0 +1,102 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "entropy.hpp"
+
+/*
+ * Quality of the last tentative, published with the game status. Amounts of
+ * information are in 1/256 bit, which keeps them on 16 bits for every
+ * variant.
+ */
+
+#define ANALYTICS_VERSION 2
+#define ANALYTICS_UNKNOWN 0xFFFF
+// Guess indexes do not fit on 16 bits for every variant
+#define ANALYTICS_UNKNOWN_GUESS 0xFFFFFFFF
+#define ANALYTICS_FRAC_BITS 8
+// Version, candidates before the tentative, three 16-bit amounts of information, best guess
+#define ANALYTICS_SERIALIZED_SIZE (1 + sizeof(uint32_t) + 3 * sizeof(uint16_t) + sizeof(uint32_t))
+
+struct guess_analytics
+{
+    // Candidates before the tentative, 0 before the first one
+    uint32_t before;
+    // Information given by the clues received: log2(before / after)
+    uint16_t gained;
+    // Information the tentative was expected to give, averaged over the candidates
+    uint16_t expected;
+    // Information expected from the hint of the device, or ANALYTICS_UNKNOWN if not computed in time
+    uint16_t best_expected;
+    // Index of the hint of the device, or ANALYTICS_UNKNOWN_GUESS
+    uint32_t best_guess;
+
+    static guess_analytics none(void)
+    {
+        return {0, 0, 0, ANALYTICS_UNKNOWN, ANALYTICS_UNKNOWN_GUESS};
+    }
+
+    /**
+     * @brief Serialize the analytics, version first, in the byte order of the device.
+     *
+     * @return A pointer to the end of the serialized data.
+     */
+    uint8_t *serialize(uint8_t *buf) const
+    {
+        *buf++ = ANALYTICS_VERSION;
+        memcpy(buf, &before, sizeof(before));
+        buf += sizeof(before);
+        memcpy(buf, &gained, sizeof(gained));
+        buf += sizeof(gained);
+        memcpy(buf, &expected, sizeof(expected));
+        buf += sizeof(expected);
+        memcpy(buf, &best_expected, sizeof(best_expected));
+        buf += sizeof(best_expected);
+        memcpy(buf, &best_guess, sizeof(best_guess));
+        return buf + sizeof(best_guess);
+    }
+};
+
+/**
+ * @brief Information given by a guess splitting count candidates, averaged over them.
+ *
+ * @param partitions Number of candidates for each clues, as counted by the solver
+ * @param count Number of candidates
+ *
+ * @return The entropy of the partition, in 1/256 bit
+ */
+template <class V>
+uint16_t analytics_expected(const etl::array<uint32_t, V::CLUES_NB> &partitions, uint32_t count)
+{
+    uint64_t total = uint64_t(count) * entropy_log2(count);
+    uint64_t sum = entropy_sum(partitions);
+
+    // The rounding of the logarithms must not make a useless guess negative
+    if (sum >= total)
+    {
+        return 0;
+    }
+
+    return uint16_t(((total - sum) / count) >> (ENTROPY_FRAC_BITS - ANALYTICS_FRAC_BITS));
+}
+
+/**
+ * @brief Information given by clues leaving after of the before candidates.
+ *
+ * @return log2(before / after), in 1/256 bit, or ANALYTICS_UNKNOWN if no candidate is left
+ */
+inline uint16_t analytics_gained(uint32_t before, uint32_t after)
+{
+    if (after == 0)
+    {
+        return ANALYTICS_UNKNOWN;
+    }
+
+    return uint16_t((entropy_log2(before) - entropy_log2(after)) >> (ENTROPY_FRAC_BITS - ANALYTICS_FRAC_BITS));
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <cstdint>
+
+/*
+ * Keyframe animations of the LED strip, with integer arithmetic only.
+ *
+ * An animation gives each LED of its target group a level, linearly
+ * interpolated between keyframes, which either scales the color of the
+ * static frame or selects a hue. Each LED starts stagger ms after the
+ * previous one of its group. A repeating animation loops until it is
+ * stopped, the others hold their last level once every LED reached it.
+ */
+
+#define ANIMATION_KEYFRAME_MAX 8
+#define ANIMATION_LEVEL_MAX 255
+// Brightness of the hues, the one of the game colors
+#define ANIMATION_HUE_MAX 0x0F
+
+struct animation_keyframe
+{
+    // Time from the start of the LED, in ms
+    uint16_t time;
+    uint8_t level;
+};
+
+enum class animation_effect : uint8_t
+{
+    // The level scales the color of the static frame
+    ANIMATION_FADE,
+    // The level is a hue, the static frame is ignored
+    ANIMATION_HUE
+};
+
+enum class animation_target : uint8_t
+{
+    ANIMATION_ALL,
+    ANIMATION_CODE,
+    ANIMATION_CLUES
+};
+
+struct animation_color
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+struct animation
+{
+    const animation_keyframe *keyframes;
+    uint8_t keyframe_nb;
+    bool repeat;
+    uint16_t stagger;
+    animation_effect effect;
+    animation_target target;
+
+    /**
+     * @brief Get the level of a LED.
+     *
+     * @param t Time from the start of the LED in ms, negative before it starts
+     */
+    constexpr uint8_t level(int32_t t) const
+    {
+        const animation_keyframe &last = keyframes[keyframe_nb - 1];
+
+        if (repeat)
+        {
+            t %= int32_t(last.time);
+            t += t < 0 ? last.time : 0;
+        }
+        if (t <= keyframes[0].time)
+        {
+            return keyframes[0].level;
+        }
+        if (t >= last.time)
+        {
+            return last.level;
+        }
+
+        uint8_t i = 1;
+        while (keyframes[i].time <= t)
+        {
+            i++;
+        }
+        const animation_keyframe &from = keyframes[i - 1];
+        const animation_keyframe &to = keyframes[i];
+        return from.level + (int32_t(to.level) - from.level) * (t - from.time) / (to.time - from.time);
+    }
+
+    /**
+     * @brief Get the time after which a non repeating animation is over.
+     *
+     * @param rank_max Highest rank of a LED in the target group
+     */
+    constexpr uint32_t length(uint8_t rank_max) const
+    {
+        return keyframes[keyframe_nb - 1].time + uint32_t(stagger) * rank_max;
+    }
+};
+
+/**
+ * @brief Scale a color by a level, rounded to the nearest.
+ */
+constexpr animation_color animation_fade(animation_color color, uint8_t level)
+{
+    return {uint8_t((color.r * level + ANIMATION_LEVEL_MAX / 2) / ANIMATION_LEVEL_MAX),
+            uint8_t((color.g * level + ANIMATION_LEVEL_MAX / 2) / ANIMATION_LEVEL_MAX),
+            uint8_t((color.b * level + ANIMATION_LEVEL_MAX / 2) / ANIMATION_LEVEL_MAX)};
+}
+
+/**
+ * @brief Get a fully saturated color of the wheel red, yellow, green, cyan, blue, magenta.
+ */
+constexpr animation_color animation_hue(uint8_t hue)
+{
+    uint16_t position = hue * 6;
+    uint8_t rise = (ANIMATION_HUE_MAX * (position & 0xFF) + 0x7F) / 0xFF;
+    uint8_t fall = ANIMATION_HUE_MAX - rise;
+
+    switch (position >> 8)
+    {
+    case 0:
+        return {ANIMATION_HUE_MAX, rise, 0};
+    case 1:
+        return {fall, ANIMATION_HUE_MAX, 0};
+    case 2:
+        return {0, ANIMATION_HUE_MAX, rise};
+    case 3:
+        return {0, fall, ANIMATION_HUE_MAX};
+    case 4:
+        return {rise, 0, ANIMATION_HUE_MAX};
+    default:
+        return {ANIMATION_HUE_MAX, 0, fall};
+    }
+}
+
+// Clue pegs pulsing three times, then back to their static colors so the animation timer stops
+inline constexpr animation_keyframe animation_clues_keyframes[] = {{0, 255},    {500, 48},  {1000, 255}, {1500, 48},
+                                                                   {2000, 255}, {2500, 48}, {3000, 255}};
+inline constexpr animation animation_clues = {animation_clues_keyframes, 7, false, 0,
+                                              animation_effect::ANIMATION_FADE, animation_target::ANIMATION_CLUES};
+
+// Rainbow rotating along the strip
+inline constexpr animation_keyframe animation_win_keyframes[] = {{0, 0}, {2000, 255}};
+inline constexpr animation animation_win = {animation_win_keyframes, 2, true, 250,
+                                            animation_effect::ANIMATION_HUE, animation_target::ANIMATION_ALL};
+
+// Secret faded in slot after slot
+inline constexpr animation_keyframe animation_reveal_keyframes[] = {{0, 0}, {300, 255}};
+inline constexpr animation animation_reveal = {animation_reveal_keyframes, 2, false, 300,
+                                               animation_effect::ANIMATION_FADE, animation_target::ANIMATION_CODE};
+
+static_assert(animation_clues.keyframe_nb <= ANIMATION_KEYFRAME_MAX &&
+                  animation_win.keyframe_nb <= ANIMATION_KEYFRAME_MAX &&
+                  animation_reveal.keyframe_nb <= ANIMATION_KEYFRAME_MAX,
+              "Too many keyframes");
+static_assert(animation_clues.level(animation_clues.length(0)) == ANIMATION_LEVEL_MAX,
+              "The clues must end on their static colors");
+
+#endif
@@ -1,6 +1,60 @@
 #ifndef APP_CFG_H
 #define APP_CFG_H
 
+#include <cstdint>
+
+#include "game_variant.hpp"
+
+// Game variant selected with Kconfig, classic Mastermind for host builds
+#ifdef CONFIG_MASTERMIND_SLOT_NB
+#define GAME_SLOT_NB CONFIG_MASTERMIND_SLOT_NB
+#define GAME_COLOR_NB CONFIG_MASTERMIND_COLOR_NB
+#define MAX_TRY CONFIG_MASTERMIND_MAX_TRY
+#else
+#define GAME_SLOT_NB 4
+#define GAME_COLOR_NB 6
 #define MAX_TRY 10
+#endif
+
+// Candidate sets of one bit per code: the one of the game, and the pending and working sets of the hint thread
+#define CANDIDATE_SET_NB 3
+// RAM budget of the candidate sets on a 64 KiB SoC, next to the Bluetooth stack and the thread stacks
+#define CANDIDATE_SETS_RAM_MAX (32 * 1024)
+
+static_assert(CANDIDATE_SET_NB * ((variant_pow(GAME_COLOR_NB, GAME_SLOT_NB) + 31) / 32) * sizeof(uint32_t) <=
+                  CANDIDATE_SETS_RAM_MAX,
+              "Candidate sets of the variant do not fit in RAM");
+
+// Entries of the partition cache: a few on the device, many more on the host
+#ifdef CONFIG_MASTERMIND_PARTITION_CACHE_SIZE
+#define PARTITION_CACHE_SIZE CONFIG_MASTERMIND_PARTITION_CACHE_SIZE
+#else
+#define PARTITION_CACHE_SIZE 4096
+#endif
+
+// Largest candidate set solved exactly by the endgame solver
+#ifdef CONFIG_MASTERMIND_ENDGAME_MAX
+#define ENDGAME_CANDIDATE_MAX CONFIG_MASTERMIND_ENDGAME_MAX
+#else
+#define ENDGAME_CANDIDATE_MAX 32
+#endif
+
+// Strategy of the hint and codebreaker searches, a solver_strategy
+#ifdef CONFIG_MASTERMIND_HINT_ENTROPY
+#define HINT_STRATEGY solver_strategy::SOLVER_ENTROPY
+#else
+#define HINT_STRATEGY solver_strategy::SOLVER_MINIMAX
+#endif
+
+enum class game_mode : uint8_t
+{
+    // The device picks the secret, the player guesses it
+    GAME_MODE_CLASSIC = 0,
+    // The player picks the secret, the device guesses it
+    GAME_MODE_CODEBREAKER,
+    // The device only commits to a secret when forced, keeping the largest set of candidates
+    GAME_MODE_EVIL,
+    GAME_MODE_MAX,
+};
 
 #endif
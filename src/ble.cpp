@@ -8,20 +8,26 @@
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/services/bas.h>
 #include <zephyr/bluetooth/services/hrs.h>
+#include <zephyr/sys/atomic.h>
 
-#include "etl/bitset.h"
 #include "etl/array.h"
+#include "etl/queue_spsc_atomic.h"
 #include "ble.hpp"
 #include "combination.hpp"
+#include "packed_combination.hpp"
 #include "app_cfg.hpp"
 
 #define BT_UUID_MSTR_SRV_VAL BT_UUID_128_ENCODE(0x00001523, 0x2929, 0xefde, 0x1523, 0x785feabcd123)
 #define BT_UUID_MSTR_STATUS_CHAR_VAL BT_UUID_128_ENCODE(0x00001524, 0x2929, 0xefde, 0x1523, 0x785feabcd123)
 #define BT_UUID_MSTR_CMD_CHAR_VAL BT_UUID_128_ENCODE(0x00001525, 0x2929, 0xefde, 0x1523, 0x785feabcd123)
+#define BT_UUID_MSTR_HINT_CHAR_VAL BT_UUID_128_ENCODE(0x00001526, 0x2929, 0xefde, 0x1523, 0x785feabcd123)
+#define BT_UUID_MSTR_STATS_CHAR_VAL BT_UUID_128_ENCODE(0x00001527, 0x2929, 0xefde, 0x1523, 0x785feabcd123)
 
 #define BT_UUID_MSTR_SRV BT_UUID_DECLARE_128(BT_UUID_MSTR_SRV_VAL)
 #define BT_UUID_MSTR_STATUS_CHAR BT_UUID_DECLARE_128(BT_UUID_MSTR_STATUS_CHAR_VAL)
 #define BT_UUID_MSTR_CMD_CHAR BT_UUID_DECLARE_128(BT_UUID_MSTR_CMD_CHAR_VAL)
+#define BT_UUID_MSTR_HINT_CHAR BT_UUID_DECLARE_128(BT_UUID_MSTR_HINT_CHAR_VAL)
+#define BT_UUID_MSTR_STATS_CHAR BT_UUID_DECLARE_128(BT_UUID_MSTR_STATS_CHAR_VAL)
 
 #define LOG_LEVEL 4
 
@@ -39,6 +45,12 @@ static ssize_t write_command(struct bt_conn *conn,
                              const struct bt_gatt_attr *attr,
                              const void *buf,
                              uint16_t len, uint16_t offset, uint8_t flags);
+static ssize_t read_hint(struct bt_conn *conn,
+                         const struct bt_gatt_attr *attr, void *buf,
+                         uint16_t len, uint16_t offset);
+static ssize_t read_stats(struct bt_conn *conn,
+                          const struct bt_gatt_attr *attr, void *buf,
+                          uint16_t len, uint16_t offset);
 
 static const struct bt_data ad[] = {
     BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
@@ -50,11 +62,31 @@ static const struct bt_data sd[] = {
     BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
 };
 
+static_assert(BT_COMMAND_BUF_SIZE >= game::SLOT_NB, "Command buffer must hold a combination");
+
 static struct bt_conn *connection;
+// Published by the FSM thread under status_lock, read by the BT RX thread
+static struct k_spinlock status_lock;
 static uint8_t status_buf[BLE_STATUS_BUF_SIZE] = {0};
-static uint8_t status_buf_len = 0;
-static etl::bitset<BT_COMMAND_COUNT> command_flags = 0;
-static etl::array<uint8_t, BT_COMMAND_BUF_SIZE> command_buf = {0};
+static uint16_t status_buf_len = 0;
+static uint8_t status_format = BLE_STATUS_V1;
+static bool status_delta = false;
+static uint8_t status_seq = 0;
+// Number of tries and secret of the last status, a delta is enough when only a tentative was added
+static uint8_t status_try_nb = 0;
+static uint32_t status_secret = UINT32_MAX;
+static uint8_t delta_buf[BLE_STATUS_DELTA_SIZE] = {0};
+// Written by the BT RX thread only, read by the FSM thread only
+static etl::queue_spsc_atomic<ble_command, BT_COMMAND_QUEUE_SIZE> command_queue;
+static atomic_t commands_received = ATOMIC_INIT(0);
+static atomic_t commands_dropped = ATOMIC_INIT(0);
+static atomic_t command_queue_max = ATOMIC_INIT(0);
+// Raised when a command is queued, so the FSM wakes up at once
+static struct k_poll_signal command_signal = K_POLL_SIGNAL_INITIALIZER(command_signal);
+// Published by the hint and FSM threads under hint_lock, read by the BT RX thread
+static struct k_spinlock hint_lock;
+static uint8_t hint_buf[BLE_HINT_BUF_SIZE] = {0};
+static uint16_t hint_buf_len = 0;
 
 BT_CONN_CB_DEFINE(conn_callbacks) = {
     .connected = connected,
@@ -70,7 +102,12 @@ BT_GATT_SERVICE_DEFINE(mstr_svc,
                        BT_GATT_CHARACTERISTIC(BT_UUID_MSTR_CMD_CHAR,
                                               BT_GATT_CHRC_WRITE,
                                               BT_GATT_PERM_WRITE, NULL, write_command,
-                                              NULL), );
+                                              NULL),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_MSTR_HINT_CHAR, BT_GATT_CHRC_NOTIFY | BT_GATT_CHRC_READ,
+                                              BT_GATT_PERM_READ, read_hint, NULL, NULL),
+                       BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_MSTR_STATS_CHAR, BT_GATT_CHRC_READ,
+                                              BT_GATT_PERM_READ, read_stats, NULL, NULL), );
 
 static void connected(struct bt_conn *conn, uint8_t err)
 {
@@ -97,6 +134,9 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
 {
     LOG_INF("Disconnected, reason 0x%02x %s", reason, bt_hci_err_to_str(reason));
     connection = NULL;
+    // The next client may only know the first format
+    status_format = BLE_STATUS_V1;
+    status_delta = false;
 }
 
 static void recycled(void)
@@ -127,11 +167,72 @@ static ssize_t read_status(struct bt_conn *conn,
                            const struct bt_gatt_attr *attr, void *buf,
                            uint16_t len, uint16_t offset)
 {
+    uint8_t status[BLE_STATUS_BUF_SIZE];
+
     LOG_INF("Received request to read game status");
-    return bt_gatt_attr_read(conn, attr, buf, len, offset,
-                             &status_buf, status_buf_len);
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    uint16_t status_len = status_buf_len;
+    memcpy(status, status_buf, status_len);
+    k_spin_unlock(&status_lock, key);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, status, status_len);
+}
+
+static ssize_t read_hint(struct bt_conn *conn,
+                         const struct bt_gatt_attr *attr, void *buf,
+                         uint16_t len, uint16_t offset)
+{
+    uint8_t hint[BLE_HINT_BUF_SIZE];
+
+    LOG_INF("Received request to read hint");
+    k_spinlock_key_t key = k_spin_lock(&hint_lock);
+    uint16_t hint_len = hint_buf_len;
+    memcpy(hint, hint_buf, hint_len);
+    k_spin_unlock(&hint_lock, key);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, hint, hint_len);
 }
 
+/**
+ * @brief Read the command queue counters and the latency statistics.
+ *
+ * The statistics are made up of the following elements:
+ * - The number of valid commands received since boot (uint32_t).
+ * - The number of commands dropped because the queue was full (uint32_t).
+ * - The highest number of commands waiting in the queue (uint32_t).
+ * - For the input, LEDs and display stages, the number of presses measured,
+ *   then the min, mean, p99 and max latency from the debounced press in us
+ *   (5 uint32_t).
+ */
+static ssize_t read_stats(struct bt_conn *conn,
+                          const struct bt_gatt_attr *attr, void *buf,
+                          uint16_t len, uint16_t offset)
+{
+    uint8_t stats[BLE_STATS_BUF_SIZE];
+    uint32_t counters[] = {
+        (uint32_t)atomic_get(&commands_received),
+        (uint32_t)atomic_get(&commands_dropped),
+        (uint32_t)atomic_get(&command_queue_max),
+    };
+
+    LOG_INF("Received request to read statistics");
+    memcpy(stats, counters, sizeof(counters));
+    uint8_t *p = stats + sizeof(counters);
+    for (uint8_t stage = 0; stage < LATENCY_STAGE_NB; stage++)
+    {
+        p = latency_get(static_cast<latency_stage>(stage)).serialize(p);
+    }
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, stats, sizeof(stats));
+}
+
+/**
+ * @brief Validate a command and queue it for the FSM.
+ *
+ * Runs in the BT RX context, the only producer of the command queue. Commands
+ * are kept in order with their own payload. When the queue is full the
+ * command is dropped and counted, and the client gets an error.
+ */
 static ssize_t write_command(struct bt_conn *conn,
                              const struct bt_gatt_attr *attr,
                              const void *buf,
@@ -155,18 +256,60 @@ static ssize_t write_command(struct bt_conn *conn,
 
     switch (cmd)
     {
+    case BT_COMMAND_CODE:
+        if (len < game::SLOT_NB + 1)
+        {
+            LOG_ERR("Incorrect code length");
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+        }
+        for (uint8_t i = 0; i < game::SLOT_NB; i++)
+        {
+            if (((uint8_t *)buf)[i + 1] >= game::COLOR_NB)
+            {
+                LOG_ERR("Incorrect code color");
+                return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+            }
+        }
+        __fallthrough;
+    case BT_COMMAND_MODE:
+        if (cmd == BT_COMMAND_MODE && (len < 2 || ((uint8_t *)buf)[1] >= uint8_t(game_mode::GAME_MODE_MAX)))
+        {
+            LOG_ERR("Incorrect game mode");
+            return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+        }
+        __fallthrough;
+    case BT_COMMAND_FORMAT:
+        if (cmd == BT_COMMAND_FORMAT &&
+            (len < 2 || (((uint8_t *)buf)[1] & (BLE_STATUS_CAPABILITY(BLE_STATUS_VERSION_MAX + 1) - 1)) == 0))
+        {
+            LOG_ERR("No supported status format");
+            return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+        }
+        __fallthrough;
     case BT_COMMAND_RESET:
     case BT_COMMAND_OFF:
-    case BT_COMMAND_CODE:
+    case BT_COMMAND_HINT:
         LOG_INF("Valid command received");
-        command_flags.set(cmd, true);
         break;
     default:
         LOG_ERR("Unknown command");
         return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
     }
 
-    memcpy(command_buf.data(), ((uint8_t *)buf) + 1, len - 1);
+    ble_command command = {cmd, uint8_t(len - 1), {0}, k_cycle_get_32()};
+    memcpy(command.payload.data(), ((uint8_t *)buf) + 1, len - 1);
+    atomic_inc(&commands_received);
+    if (!command_queue.push(command))
+    {
+        LOG_ERR("Command queue full, command %u dropped", cmd);
+        atomic_inc(&commands_dropped);
+        return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+    }
+    if ((atomic_val_t)command_queue.size() > atomic_get(&command_queue_max))
+    {
+        atomic_set(&command_queue_max, command_queue.size());
+    }
+    k_poll_signal_raise(&command_signal, cmd);
 
     return len;
 }
@@ -196,45 +339,266 @@ bool ble_init(void)
     return true;
 }
 
+/**
+ * @brief Append a field to a little endian bit stream.
+ *
+ * @param buf The stream, whose bytes after the current one must be zero.
+ * @param bit_pos The current position in bits, advanced past the field.
+ */
+static void put_bits(uint8_t *buf, uint32_t &bit_pos, uint32_t value, uint8_t width)
+{
+    for (uint8_t i = 0; i < width; i++, bit_pos++)
+    {
+        if (value & (1UL << i))
+        {
+            buf[bit_pos / 8] |= 1 << (bit_pos % 8);
+        }
+    }
+}
+
+/**
+ * @brief Get the index of the secret, or game::CODE_NB if it is not set.
+ */
+static uint32_t secret_index(const combination &code)
+{
+    for (const slot &s : code.slots)
+    {
+        if (!s.set)
+        {
+            return game::CODE_NB;
+        }
+    }
+
+    return code.index();
+}
+
+/**
+ * @brief Serialize the game status in the bit-packed v2 format.
+ *
+ * See BLE_STATUS_V2_SIZE for the layout, and BLE_STATUS_V2_TRAILER_SIZE for
+ * the trailing section.
+ *
+ * @param buf The buffer receiving the status, of BLE_STATUS_BUF_SIZE bytes.
+ *
+ * @return The size of the status, in bytes.
+ */
+static uint16_t serialize_status_v2(uint8_t *buf, etl::array<packed_tentative, MAX_TRY> &tentatives,
+                                    uint32_t secret, uint8_t try_nb, uint32_t candidates,
+                                    const guess_analytics &analytics)
+{
+    uint32_t bit_pos = 0;
+    uint16_t len = BLE_STATUS_V2_SIZE(try_nb);
+
+    memset(buf, 0, len);
+    buf[0] = (BLE_STATUS_V2 << 4) | try_nb;
+    buf[1] = (game::SLOT_NB << 4) | game::COLOR_NB;
+    put_bits(&buf[2], bit_pos, secret, BLE_STATUS_V2_SECRET_BITS);
+    for (uint8_t i = 0; i < try_nb; i++)
+    {
+        put_bits(&buf[2], bit_pos, tentatives[i].code.index() * game::CLUES_NB + tentatives[i].clues,
+                 BLE_STATUS_V2_TENTATIVE_BITS);
+    }
+
+    memcpy(&buf[len], &candidates, sizeof(candidates));
+    uint8_t *end = analytics.serialize(&buf[len + sizeof(candidates)]);
+
+    return end - &buf[0];
+}
+
+/**
+ * @brief Select the status format, among the ones supported by the client.
+ *
+ * @param capabilities The formats supported by the client, bit BLE_STATUS_CAPABILITY(version) for each,
+ * and BLE_STATUS_CAPABILITY_DELTA to get delta notifications.
+ *
+ * @return true if a format is supported by both sides, false otherwise.
+ */
+bool ble_set_status_format(uint8_t capabilities)
+{
+    for (uint8_t version = BLE_STATUS_VERSION_MAX; version >= BLE_STATUS_V1; version--)
+    {
+        if (capabilities & BLE_STATUS_CAPABILITY(version))
+        {
+            status_format = version;
+            // A delta only carries the fields of the v2 status
+            status_delta = version == BLE_STATUS_V2 && (capabilities & BLE_STATUS_CAPABILITY_DELTA);
+            LOG_INF("Status format v%u selected%s", version, status_delta ? ", with deltas" : "");
+            return true;
+        }
+    }
+
+    LOG_ERR("No supported status format");
+    return false;
+}
+
+/**
+ * @brief Notify the connected device, if it subscribed to the status.
+ */
+static void notify_status(const uint8_t *buf, uint16_t len)
+{
+    LOG_HEXDUMP_INF(buf, len, "Status buffer");
+    const struct bt_gatt_attr *attr = &mstr_svc.attrs[1];
+    if (connection && bt_gatt_is_subscribed(connection, attr, BT_GATT_CCC_NOTIFY))
+    {
+        LOG_INF("Sending notification to update game status");
+        int err = bt_gatt_notify(connection, attr, buf, len);
+        if (err)
+        {
+            LOG_ERR("Failed to send notification (err %d)", err);
+        }
+    }
+}
+
 /**
  * @brief Updates the game status buffer, which is then sent to connected devices.
  *
- * The game status is made up of the following elements:
+ * In delta mode, when the only change since the last status is a new
+ * tentative, only this tentative is notified, see BLE_STATUS_DELTA_SIZE. The
+ * whole status is still kept for the reads.
+ *
+ * The status is built aside, then published under status_lock, so a read
+ * from the BT RX thread never sees a half written status.
+ *
+ * Once the client selected the v2 format, the bit-packed board is sent with
+ * the candidates and the analytics, see BLE_STATUS_V2_SIZE. Otherwise the game status is made up of the
+ * following elements:
  * - The correct combination (code) object, serialized.
  * - The number of tries that have been made so far.
- * - The combinations that have been tried before, serialized.
+ * - The combinations that have been tried before, unpacked and serialized.
+ * - The number of secrets still consistent with all the clues (uint32_t).
+ * - The analytics of the last tentative: a version byte, the candidates before
+ *   it (uint32_t), then in 1/256 bit the information gained, the information
+ *   expected, the information expected from the hint (uint16_t each), and the
+ *   index of the hint (uint32_t). Unknown values are 0xFFFF, and 0xFFFFFFFF
+ *   for the index.
  *
  * @param tentatives The tentative combinations that have been tried.
  * @param code The correct combination.
  * @param try_nb The number of tries that have been made so far.
+ * @param candidates The number of secrets still consistent with all the clues.
+ * @param analytics The analytics of the last tentative.
  */
-void ble_update_status(etl::array<combination, MAX_TRY> &tentatives, combination &code, uint8_t try_nb)
+void ble_update_status(etl::array<packed_tentative, MAX_TRY> &tentatives, combination &code, uint8_t try_nb,
+                       uint32_t candidates, const guess_analytics &analytics)
 {
-    uint8_t *buf_ptr = status_buf;
+    uint8_t status[BLE_STATUS_BUF_SIZE];
+    uint16_t status_len;
+    uint8_t *buf_ptr = status;
+    combination tentative;
+    uint32_t secret = secret_index(code);
+    bool delta = status_delta && try_nb == status_try_nb + 1 && secret == status_secret;
+
+    if (status_format == BLE_STATUS_V2)
+    {
+        status_len = serialize_status_v2(status, tentatives, secret, try_nb, candidates, analytics);
+    }
+    else
+    {
+        buf_ptr = code.serialize(buf_ptr);
+        memcpy(buf_ptr, &try_nb, sizeof(try_nb));
+        buf_ptr += sizeof(try_nb);
+        for (uint8_t i = 0; i < try_nb; i++)
+        {
+            tentatives[i].unpack(tentative);
+            buf_ptr = tentative.serialize(buf_ptr);
+        }
+        memcpy(buf_ptr, &candidates, sizeof(candidates));
+        buf_ptr += sizeof(candidates);
+        buf_ptr = analytics.serialize(buf_ptr);
+        status_len = buf_ptr - &status[0];
+    }
 
-    buf_ptr = code.serialize(buf_ptr);
-    memcpy(buf_ptr, &try_nb, sizeof(try_nb));
-    buf_ptr += sizeof(try_nb);
-    for (uint8_t i = 0; i < try_nb; i++)
+    status_seq++;
+    status_try_nb = try_nb;
+    status_secret = secret;
+    if (status_delta)
     {
-        buf_ptr = tentatives[i].serialize(buf_ptr);
+        status[status_len++] = status_seq;
     }
 
-    status_buf_len = buf_ptr - &status_buf[0];
-    ble_status_notify();
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    memcpy(status_buf, status, status_len);
+    status_buf_len = status_len;
+    k_spin_unlock(&status_lock, key);
+
+    if (delta)
+    {
+        uint32_t value = tentatives[try_nb - 1].code.index() * game::CLUES_NB + tentatives[try_nb - 1].clues;
+
+        delta_buf[0] = (BLE_STATUS_DELTA_TAG << 4) | try_nb;
+        delta_buf[1] = status_seq;
+        for (uint8_t i = 0; i < BLE_STATUS_DELTA_TENTATIVE_SIZE; i++)
+        {
+            delta_buf[2 + i] = value >> (8 * i);
+        }
+        memcpy(&delta_buf[2 + BLE_STATUS_DELTA_TENTATIVE_SIZE], &status[BLE_STATUS_V2_SIZE(try_nb)],
+               BLE_STATUS_V2_TRAILER_SIZE);
+        notify_status(delta_buf, sizeof(delta_buf));
+    }
+    else
+    {
+        notify_status(status, status_len);
+    }
 }
 
 /**
- * @brief Notify the connected device about the game status.
+ * @brief Notify the connected device about the whole game status.
  */
 void ble_status_notify(void)
 {
-    LOG_HEXDUMP_INF(status_buf, status_buf_len, "Status buffer");
-    const struct bt_gatt_attr *attr = &mstr_svc.attrs[1];
+    uint8_t status[BLE_STATUS_BUF_SIZE];
+
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    uint16_t status_len = status_buf_len;
+    memcpy(status, status_buf, status_len);
+    k_spin_unlock(&status_lock, key);
+
+    notify_status(status, status_len);
+}
+
+/**
+ * @brief Updates the hint buffer, and notify the connected device.
+ *
+ * The hint is made up of the following elements:
+ * - The hinted combination, serialized.
+ * - The number of candidates the hint was computed for (uint32_t).
+ * - The search time in milliseconds (uint32_t).
+ * - The hits and misses of the partition cache since boot (uint32_t each).
+ *
+ * Called from both the hint thread and the FSM thread. The hint is built
+ * aside, then published under hint_lock, which read_hint takes too.
+ *
+ * @param hint The hinted combination.
+ * @param candidates The number of candidates the hint was computed for.
+ * @param elapsed_ms The search time in milliseconds.
+ * @param cache The partition cache counters.
+ */
+void ble_update_hint(combination &hint, uint32_t candidates, uint32_t elapsed_ms, const partition_cache_stats &cache)
+{
+    uint8_t hint_data[BLE_HINT_BUF_SIZE];
+    uint8_t *buf_ptr = hint_data;
+
+    buf_ptr = hint.serialize(buf_ptr);
+    memcpy(buf_ptr, &candidates, sizeof(candidates));
+    buf_ptr += sizeof(candidates);
+    memcpy(buf_ptr, &elapsed_ms, sizeof(elapsed_ms));
+    buf_ptr += sizeof(elapsed_ms);
+    memcpy(buf_ptr, &cache.hits, sizeof(cache.hits));
+    buf_ptr += sizeof(cache.hits);
+    memcpy(buf_ptr, &cache.misses, sizeof(cache.misses));
+    buf_ptr += sizeof(cache.misses);
+    uint16_t hint_len = buf_ptr - &hint_data[0];
+
+    k_spinlock_key_t key = k_spin_lock(&hint_lock);
+    memcpy(hint_buf, hint_data, hint_len);
+    hint_buf_len = hint_len;
+    k_spin_unlock(&hint_lock, key);
+
+    const struct bt_gatt_attr *attr = &mstr_svc.attrs[6];
     if (connection && bt_gatt_is_subscribed(connection, attr, BT_GATT_CCC_NOTIFY))
     {
-        LOG_INF("Sending notification to update game status");
-        int err = bt_gatt_notify(connection, attr, status_buf, status_buf_len);
+        LOG_INF("Sending notification with hint");
+        int err = bt_gatt_notify(connection, attr, hint_data, hint_len);
         if (err)
         {
             LOG_ERR("Failed to send notification (err %d)", err);
@@ -243,21 +607,28 @@ void ble_status_notify(void)
 }
 
 /**
- * @brief Returns a reference to the command flags bitset.
+ * @brief Take the oldest command written by the client.
  *
- * @return A reference to the command flags bitset.
+ * Must only be called from the FSM thread, the only consumer of the queue.
+ *
+ * @param command Receives the command and its payload.
+ *
+ * @return true if a command was taken, false if the queue is empty.
  */
-etl::bitset<BT_COMMAND_COUNT> &ble_get_commands(void)
+bool ble_pop_command(ble_command &command)
 {
-    return command_flags;
+    return command_queue.pop(command);
 }
 
 /**
- * @brief Returns a reference to the command buffer array.
+ * @brief Returns the signal raised each time a command is queued.
  *
- * @return A reference to the command buffer array.
+ * The consumer resets it before emptying the queue, so a command queued in
+ * the meantime raises it again.
+ *
+ * @return A pointer to the command signal.
  */
-etl::array<uint8_t, BT_COMMAND_BUF_SIZE> &ble_get_command_buf(void)
+struct k_poll_signal *ble_get_command_signal(void)
 {
-    return command_buf;
-}
\ No newline at end of file
+    return &command_signal;
+}
@@ -1,24 +1,98 @@
 #ifndef BLE_H
 #define BLE_H
 
-#include "etl/bitset.h"
+#include <zephyr/kernel.h>
+
 #include "etl/array.h"
 
 #include "combination.hpp"
+#include "packed_combination.hpp"
+#include "partition_cache.hpp"
+#include "analytics.hpp"
+#include "latency.hpp"
 #include "app_cfg.hpp"
 
-#define BLE_STATUS_BUF_SIZE 128
+// Serialized code, number of tries, serialized tentatives, number of candidates, analytics and sequence number
+#define BLE_STATUS_BUF_SIZE \
+    (combination::SERIALIZED_SIZE * (MAX_TRY + 1) + 1 + sizeof(uint32_t) + ANALYTICS_SERIALIZED_SIZE + 1)
 
 #define BT_COMMAND_RESET 0
 #define BT_COMMAND_OFF 1
 #define BT_COMMAND_CODE 2
-#define BT_COMMAND_COUNT 3
+#define BT_COMMAND_HINT 3
+#define BT_COMMAND_MODE 4
+#define BT_COMMAND_FORMAT 5
 #define BT_COMMAND_BUF_SIZE 8
+// Commands received but not executed yet by the FSM
+#define BT_COMMAND_QUEUE_SIZE 8
+// Serialized hint, number of candidates, search time, partition cache hits and misses
+#define BLE_HINT_BUF_SIZE (combination::SERIALIZED_SIZE + 4 * sizeof(uint32_t))
+// Commands received, commands dropped on a full queue, highest queue occupancy, latency of each stage
+#define BLE_STATS_BUF_SIZE (3 * sizeof(uint32_t) + LATENCY_STAGE_NB * LATENCY_SERIALIZED_SIZE)
+
+/**
+ * @brief Command written by the client, with its payload.
+ */
+struct ble_command
+{
+    uint8_t id;
+    uint8_t len;
+    etl::array<uint8_t, BT_COMMAND_BUF_SIZE> payload;
+    // Cycle counter when the command was received, to measure its latency
+    uint32_t received;
+};
+
+// Status formats, the client announces the ones it supports with BT_COMMAND_FORMAT, one bit per version
+#define BLE_STATUS_V1 1
+#define BLE_STATUS_V2 2
+#define BLE_STATUS_VERSION_MAX BLE_STATUS_V2
+#define BLE_STATUS_CAPABILITY(version) (1 << ((version) - 1))
+
+/*
+ * Bit-packed v2 status: a byte with the version in the high nibble and the
+ * number of tries in the low one, a byte with the number of slots and of
+ * colors, then least significant bit first the index of the secret (CODE_NB
+ * when it is not set) and each tentative as index * CLUES_NB + clues. The
+ * board is followed by a trailing section with the number of candidates
+ * (uint32_t) and the analytics, as in v1. Clients find it from the length.
+ */
+#define BLE_STATUS_V2_SECRET_BITS variant_bit_width(game::CODE_NB)
+#define BLE_STATUS_V2_TENTATIVE_BITS variant_bit_width(game::CODE_NB * game::CLUES_NB - 1)
+#define BLE_STATUS_V2_SIZE(try_nb) \
+    (2 + (BLE_STATUS_V2_SECRET_BITS + (try_nb) * BLE_STATUS_V2_TENTATIVE_BITS + 7) / 8)
+#define BLE_STATUS_V2_TRAILER_SIZE (sizeof(uint32_t) + ANALYTICS_SERIALIZED_SIZE)
+
+// Capability bit asking for delta notifications, along with the formats
+#define BLE_STATUS_CAPABILITY_DELTA (1 << 7)
+
+/*
+ * Delta notification, sent in delta mode instead of the status when the only
+ * change is a new tentative: a byte with BLE_STATUS_DELTA_TAG in the high
+ * nibble and the number of tries in the low one, the sequence number, the
+ * tentative coded as in v2, little endian, then the trailing section of the
+ * v2 status, which changes with each tentative. Deltas are only sent with the
+ * v2 format. In delta mode the status, read or notified, ends with its
+ * sequence number: a client which misses a delta reads the status again.
+ */
+#define BLE_STATUS_DELTA_TAG 0xD
+#define BLE_STATUS_DELTA_TENTATIVE_SIZE ((BLE_STATUS_V2_TENTATIVE_BITS + 7) / 8)
+#define BLE_STATUS_DELTA_SIZE (2 + BLE_STATUS_DELTA_TENTATIVE_SIZE + BLE_STATUS_V2_TRAILER_SIZE)
+
+static_assert(MAX_TRY < 16 && game::SLOT_NB < 16 && game::COLOR_NB < 16, "v2 status header fields are 4 bits");
+static_assert(BLE_STATUS_V2_SIZE(MAX_TRY) + BLE_STATUS_V2_TRAILER_SIZE + 1 <= BLE_STATUS_BUF_SIZE,
+              "v2 status must fit in the status buffer");
+
+#ifdef CONFIG_BT_L2CAP_TX_MTU
+static_assert(BLE_STATUS_BUF_SIZE <= CONFIG_BT_L2CAP_TX_MTU - 3, "Status must fit in a single notification");
+#endif
 
 bool ble_init(void);
-void ble_update_status(etl::array<combination, MAX_TRY> &tentatives, combination &code, uint8_t try_nb);
+void ble_update_status(etl::array<packed_tentative, MAX_TRY> &tentatives, combination &code, uint8_t try_nb,
+                       uint32_t candidates, const guess_analytics &analytics);
 void ble_status_notify();
-etl::bitset<BT_COMMAND_COUNT> &ble_get_commands(void);
-etl::array<uint8_t, BT_COMMAND_BUF_SIZE> &ble_get_command_buf(void);
+bool ble_set_status_format(uint8_t capabilities);
+void ble_update_hint(combination &hint, uint32_t candidates, uint32_t elapsed_ms, const partition_cache_stats &cache);
+bool ble_pop_command(ble_command &command);
+struct k_poll_signal *ble_get_command_signal(void);
 
 #endif
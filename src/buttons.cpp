@@ -2,131 +2,142 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
-#include <zephyr/drivers/gpio.h>
+#include <zephyr/input/input.h>
+#include <zephyr/sys/atomic.h>
 
 #include "buttons.hpp"
+#include "latency.hpp"
 
 #define LOG_LEVEL 4
-#define DEBOUNCE_TIME 200
 
 LOG_MODULE_REGISTER(buttons);
 
-static struct k_poll_signal signal;
+K_MSGQ_DEFINE(button_queue, sizeof(button_event), BUTTON_QUEUE_SIZE, 4);
+static atomic_t button_events = ATOMIC_INIT(0);
+static atomic_t button_overflows = ATOMIC_INIT(0);
+static const struct device *const keys = DEVICE_DT_GET(DT_NODELABEL(buttons));
 
 /**
- * @brief Raise a signal based on the pressed button.
+ * @brief Queue the edges of the buttons, with their time.
  *
- * @param dev The device that triggered the callback.
- * @param cb The callback structure.
- * @param pins The pin number of the pressed button.
+ * The gpio-keys driver debounces each key with its own timer, and reports
+ * both edges. An event is dropped and counted when the queue is full.
+ *
+ * @param evt The input event.
+ * @param user_data Unused.
  */
-static void button_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+static void button_input(struct input_event *evt, void *user_data)
 {
-	static int64_t last_button_pressed = 0;
-	// Debounce all the buttons together, no concurrent button presses allowed
-	int64_t current_tick = k_uptime_get();
-	if (current_tick - last_button_pressed > DEBOUNCE_TIME)
+	if (evt->type != INPUT_EV_KEY)
+	{
+		return;
+	}
+
+	for (uint8_t i = 0; i < buttons::codes.size(); i++)
 	{
-		k_poll_signal_raise(&signal, pins);
-		last_button_pressed = current_tick;
+		if (buttons::codes[i] == evt->code)
+		{
+			// Timed after the debounce interval of the driver, not at the GPIO edge
+			button_event event = {i, evt->value != 0, k_cycle_get_32()};
+
+			atomic_inc(&button_events);
+			if (k_msgq_put(&button_queue, &event, K_NO_WAIT) != 0)
+			{
+				LOG_WRN("Button queue full, %u events dropped", (uint32_t)atomic_inc(&button_overflows) + 1);
+			}
+			return;
+		}
 	}
+
+	LOG_WRN("Unknown key code %u", evt->code);
 }
 
+INPUT_CALLBACK_DEFINE(keys, button_input, NULL);
+
 /**
  * @brief Wait for a button press event with a given timeout.
  *
+ * The thread sleeps in a single k_poll() on the button queue and on the
+ * optional wakeup signal, which is left raised for its owner to reset. The
+ * presses are returned in order, the releases are skipped.
+ *
  * @param timeout The timeout in milliseconds.
- * @return The button value of the pressed button, or BUTTON_VAL_NONE if no event was received.
+ * @param wakeup A signal which also ends the wait, or nullptr.
+ * @return The button value of the oldest press, or BUTTON_VAL_NONE if no button was pressed.
  */
-button_val buttons::wait_for_input(k_timeout_t timeout)
+button_val buttons::wait_for_input(k_timeout_t timeout, struct k_poll_signal *wakeup)
 {
-	unsigned int signaled;
-	int result;
-	int index = 0;
-	button_val ret = button_val::BUTTON_VAL_NONE;
-	struct k_poll_event events[1] = {
+	button_event event;
+	k_timepoint_t end = sys_timepoint_calc(timeout);
+	struct k_poll_event events[2] = {
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+								 K_POLL_MODE_NOTIFY_ONLY,
+								 &button_queue),
 		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL,
 								 K_POLL_MODE_NOTIFY_ONLY,
-								 &signal),
+								 wakeup),
 	};
 
-	k_poll(events, 1, timeout);
-	k_poll_signal_check(&signal, &signaled, &result);
-
-	if (signaled)
+	while (k_poll(events, wakeup ? 2 : 1, sys_timepoint_timeout(end)) == 0)
 	{
-		for (const auto &i : specs)
+		while (k_msgq_get(&button_queue, &event, K_NO_WAIT) == 0)
 		{
-			if (BIT(i.pin) == result)
+			if (event.pressed)
 			{
-				ret = static_cast<button_val>(index);
-				break;
+				latency_press(event.cycles);
+				latency_stage_done(LATENCY_STAGE_INPUT);
+				return static_cast<button_val>(event.key);
 			}
-			index++;
 		}
+
+		if (wakeup && events[1].state == K_POLL_STATE_SIGNALED)
+		{
+			break;
+		}
+		events[0].state = K_POLL_STATE_NOT_READY;
 	}
-	else
+
+	return button_val::BUTTON_VAL_NONE;
+}
+
+/**
+ * @brief Drop the button events not read yet.
+ */
+void buttons::flush(void)
+{
+	uint32_t stale = k_msgq_num_used_get(&button_queue);
+
+	if (stale)
 	{
-		ret = button_val::BUTTON_VAL_NONE;
+		LOG_INF("Dropping %u stale button events", stale);
 	}
+	k_msgq_purge(&button_queue);
+}
 
-	k_poll_signal_reset(&signal);
-	events[0].state = K_POLL_STATE_NOT_READY;
-	return ret;
+/**
+ * @brief Get the counters of the button events since boot.
+ */
+button_stats buttons::get_stats(void)
+{
+	return {(uint32_t)atomic_get(&button_events), (uint32_t)atomic_get(&button_overflows)};
 }
 
 /**
  * @brief Initialise the buttons module.
  *
+ * The keys are configured by the gpio-keys driver, from the devicetree.
+ *
  * @return true if the initialization was successful, false otherwise.
  */
 bool buttons::init(void)
 {
-	int ret;
-	gpio_port_pins_t pin_mask;
-
 	LOG_INF("Initializing buttons");
 
-	for (const auto &i : specs)
+	if (!device_is_ready(keys))
 	{
-		if (!device_is_ready(i.port))
-		{
-			LOG_ERR("Device is not ready");
-			return false;
-		}
-
-		ret = gpio_pin_configure_dt(&i, GPIO_INPUT);
-		if (ret < 0)
-		{
-			LOG_ERR("Couldn't configure pin: %d", ret);
-			return false;
-		}
-
-		ret = gpio_pin_interrupt_configure_dt(&i, GPIO_INT_LEVEL_ACTIVE);
-		if (ret < 0)
-		{
-			LOG_ERR("Couldn't configure pin interrupt: %d", ret);
-			return false;
-		}
-
-		WRITE_BIT(pin_mask, i.pin, 1);
-	}
-
-	// Initialize polling signal
-	k_poll_signal_init(&signal);
-
-	// Adding interrupt callback
-	gpio_init_callback(&cb_data, button_pressed, pin_mask);
-
-	for (const auto &i : specs)
-	{
-		ret = gpio_add_callback_dt(&i, &cb_data);
-		if (ret < 0)
-		{
-			LOG_ERR("Couldn't add callback: %d", ret);
-			return false;
-		}
+		LOG_ERR("Device is not ready");
+		return false;
 	}
 
 	return true;
-}
\ No newline at end of file
+}
@@ -5,7 +5,6 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
-#include <zephyr/drivers/gpio.h>
 
 #include "etl/array.h"
 
@@ -17,24 +16,55 @@ enum class button_val : uint8_t
     BUTTON_VAL_4,
     BUTTON_VAL_5,
     BUTTON_VAL_6,
+    BUTTON_VAL_7,
+    BUTTON_VAL_8,
     BUTTON_VAL_NONE,
     BUTTON_VAL_MAX,
 };
 
+// Button events waiting for the FSM, the oldest ones are kept when it is full
+#define BUTTON_QUEUE_SIZE 8
+
+/**
+ * @brief Edge of a button, as queued by the input callback.
+ */
+struct button_event
+{
+    uint8_t key;
+    bool pressed;
+    // Cycle counter when the event was reported
+    uint32_t cycles;
+};
+
+struct button_stats
+{
+    uint32_t events;
+    // Events dropped because the queue was full
+    uint32_t overflows;
+};
+
+// Optional buttons, for the variants with more than 6 colors
+#define BUTTON_OPT_CODE(label) \
+    COND_CODE_1(DT_NODE_EXISTS(DT_NODELABEL(label)), (, DT_PROP(DT_NODELABEL(label), zephyr_code)), ())
+#define BUTTONS_NB (6 + DT_NODE_EXISTS(DT_NODELABEL(button_cyan)) + DT_NODE_EXISTS(DT_NODELABEL(button_orange)))
+
 class buttons
 {
 public:
     bool init(void);
-    button_val wait_for_input(k_timeout_t timeout);
-
-private:
-    const etl::array<struct gpio_dt_spec, 6> specs = {{GPIO_DT_SPEC_GET(DT_NODELABEL(button_white), gpios),
-                                                       GPIO_DT_SPEC_GET(DT_NODELABEL(button_red), gpios),
-                                                       GPIO_DT_SPEC_GET(DT_NODELABEL(button_green), gpios),
-                                                       GPIO_DT_SPEC_GET(DT_NODELABEL(button_blue), gpios),
-                                                       GPIO_DT_SPEC_GET(DT_NODELABEL(button_yellow), gpios),
-                                                       GPIO_DT_SPEC_GET(DT_NODELABEL(button_gray), gpios)}};
-    struct gpio_callback cb_data;
+    button_val wait_for_input(k_timeout_t timeout, struct k_poll_signal *wakeup = nullptr);
+    void flush(void);
+    button_stats get_stats(void);
+
+    // Input codes of the gpio-keys, in the order of button_val
+    static constexpr etl::array<uint16_t, BUTTONS_NB> codes = {{DT_PROP(DT_NODELABEL(button_white), zephyr_code),
+                                                               DT_PROP(DT_NODELABEL(button_red), zephyr_code),
+                                                               DT_PROP(DT_NODELABEL(button_green), zephyr_code),
+                                                               DT_PROP(DT_NODELABEL(button_blue), zephyr_code),
+                                                               DT_PROP(DT_NODELABEL(button_yellow), zephyr_code),
+                                                               DT_PROP(DT_NODELABEL(button_gray), zephyr_code)
+                                                               BUTTON_OPT_CODE(button_cyan)
+                                                               BUTTON_OPT_CODE(button_orange)}};
 };
 
 #endif
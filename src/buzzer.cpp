@@ -7,6 +7,8 @@
 #include "buzzer.hpp"
 
 #define BUZZER_STACK 1024
+// Above the hint search, so a note ends on time while a search runs
+#define BUZZER_PRIORITY (K_LOWEST_APPLICATION_THREAD_PRIO - 1)
 #define LOG_LEVEL 4
 
 LOG_MODULE_REGISTER(buzzer);
@@ -39,7 +41,7 @@ buzzer::buzzer()
                                K_THREAD_STACK_SIZEOF(threadStack),
                                buzzer::thread,
                                this, NULL, NULL,
-                               K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
+                               BUZZER_PRIORITY, 0, K_NO_WAIT);
 }
 
 /**
@@ -0,0 +1,137 @@
+#ifndef CANDIDATE_SET_H
+#define CANDIDATE_SET_H
+
+#include <cstdint>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "packed_combination.hpp"
+
+/**
+ * @brief Set of the secrets still consistent with all the clues given so far.
+ *
+ * One bit per combination of the code space, indexed like
+ * basic_combination::index(). The set is pruned after each tentative, so the
+ * history never needs to be checked again. The classic game needs 164 bytes.
+ */
+template <class V>
+class basic_candidate_set
+{
+public:
+    static constexpr uint32_t WORD_NB = (V::CODE_NB + 31) / 32;
+
+    basic_candidate_set(void)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Mark all the combinations as candidates.
+     */
+    void reset(void)
+    {
+        for (auto &word : words)
+        {
+            word = UINT32_MAX;
+        }
+        if (V::CODE_NB % 32)
+        {
+            words[WORD_NB - 1] = (uint32_t(1) << (V::CODE_NB % 32)) - 1;
+        }
+        remaining = V::CODE_NB;
+    }
+
+    /**
+     * @brief Remove the candidates which would not give the same clues to the guess.
+     *
+     * @param guess Index of the guessed combination
+     * @param clues Clues given to the guess, packed with V::clues_pack()
+     *
+     * @return The number of candidates left
+     */
+    uint32_t prune(uint32_t guess, uint8_t clues)
+    {
+        remaining = 0;
+
+        for (uint32_t w = 0; w < WORD_NB; w++)
+        {
+            uint32_t word = words[w];
+            uint32_t kept = 0;
+
+            while (word)
+            {
+                uint8_t bit = __builtin_ctz(word);
+                word &= word - 1;
+                if (clues_score<V>(guess, w * 32 + bit) == clues)
+                {
+                    kept |= uint32_t(1) << bit;
+                }
+            }
+
+            words[w] = kept;
+            remaining += __builtin_popcount(kept);
+        }
+
+        return remaining;
+    }
+
+    bool test(uint32_t index) const
+    {
+        return words[index / 32] & (uint32_t(1) << (index % 32));
+    }
+
+    uint32_t count(void) const
+    {
+        return remaining;
+    }
+
+    /**
+     * @brief Get the lowest index of the candidates, or V::CODE_NB if there is none.
+     */
+    uint32_t first(void) const
+    {
+        for (uint32_t w = 0; w < WORD_NB; w++)
+        {
+            if (words[w])
+            {
+                return w * 32 + __builtin_ctz(words[w]);
+            }
+        }
+
+        return V::CODE_NB;
+    }
+
+    /**
+     * @brief Get the word holding the candidates w * 32 to w * 32 + 31.
+     */
+    uint32_t word(uint32_t w) const
+    {
+        return words[w];
+    }
+
+    /**
+     * @brief Call the given function with the index of each candidate, in order.
+     */
+    template <typename F>
+    void for_each(F function) const
+    {
+        for (uint32_t w = 0; w < WORD_NB; w++)
+        {
+            uint32_t word = words[w];
+            while (word)
+            {
+                uint8_t bit = __builtin_ctz(word);
+                word &= word - 1;
+                function(w * 32 + bit);
+            }
+        }
+    }
+
+private:
+    etl::array<uint32_t, WORD_NB> words;
+    uint32_t remaining;
+};
+
+using candidate_set = basic_candidate_set<game>;
+
+#endif
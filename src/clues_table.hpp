@@ -0,0 +1,162 @@
+#ifndef CLUES_TABLE_H
+#define CLUES_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "game_variant.hpp"
+
+/*
+ * Constexpr generated lookup tables used to score a guess against a secret,
+ * both given by their index in the code space.
+ *
+ * A full (guess x secret) table would be 1296 x 1296 entries for the classic
+ * game, too large for the flash of the nRF52, so the table is factored in two
+ * lookups which are both generated at compile time:
+ * - The correct clues are the sum of the matches of the high and low parts of
+ *   the combinations, read from (part x part) tables.
+ * - The correct + present clues only depend on the colors used, so every code
+ *   is mapped to its color multiset, and a (multiset x multiset) table gives
+ *   the number of colors in common. This table is packed as nibbles.
+ *
+ * The tables are only enabled for variants where they fit in
+ * CLUES_TABLE_MAX_SIZE, other variants are scored with packed combinations.
+ */
+
+#define CLUES_TABLE_MAX_SIZE (16 * 1024)
+
+template <class V>
+struct clues_table
+{
+    static constexpr uint8_t HIGH_SLOT_NB = V::SLOT_NB / 2;
+    static constexpr uint8_t LOW_SLOT_NB = V::SLOT_NB - HIGH_SLOT_NB;
+    // Number of different high and low parts
+    static constexpr uint32_t HIGH_NB = variant_pow(V::COLOR_NB, HIGH_SLOT_NB);
+    static constexpr uint32_t LOW_NB = variant_pow(V::COLOR_NB, LOW_SLOT_NB);
+    // Number of different color multisets (combinations with repetition)
+    static constexpr uint32_t MULTISET_NB = variant_binomial(V::SLOT_NB + V::COLOR_NB - 1, V::SLOT_NB);
+
+    static constexpr size_t SIZE = HIGH_NB * HIGH_NB + LOW_NB * LOW_NB + V::CODE_NB +
+                                   (size_t(MULTISET_NB) * MULTISET_NB + 1) / 2;
+    static constexpr bool ENABLED = SIZE <= CLUES_TABLE_MAX_SIZE && MULTISET_NB <= UINT8_MAX + 1;
+
+    uint8_t high_correct[ENABLED ? HIGH_NB * HIGH_NB : 1];
+    uint8_t low_correct[ENABLED ? LOW_NB * LOW_NB : 1];
+    uint8_t multiset[ENABLED ? V::CODE_NB : 1];
+    uint8_t common[ENABLED ? (MULTISET_NB * MULTISET_NB + 1) / 2 : 1];
+
+    /**
+     * @brief Count the matching slots of two parts of combinations.
+     */
+    static constexpr uint8_t part_correct(uint32_t a, uint32_t b, uint8_t slot_nb)
+    {
+        uint8_t correct = 0;
+
+        for (uint8_t i = 0; i < slot_nb; i++)
+        {
+            correct += (a % V::COLOR_NB) == (b % V::COLOR_NB);
+            a /= V::COLOR_NB;
+            b /= V::COLOR_NB;
+        }
+
+        return correct;
+    }
+
+    /**
+     * @brief Generate the clues lookup tables at compile time.
+     */
+    static constexpr clues_table generate(void)
+    {
+        static_assert(ENABLED, "Clues table is too large for this variant");
+
+        clues_table table{};
+        uint8_t histograms[MULTISET_NB][V::COLOR_NB]{};
+        uint32_t multiset_found = 0;
+
+        for (uint32_t a = 0; a < HIGH_NB; a++)
+        {
+            for (uint32_t b = 0; b < HIGH_NB; b++)
+            {
+                table.high_correct[a * HIGH_NB + b] = part_correct(a, b, HIGH_SLOT_NB);
+            }
+        }
+
+        for (uint32_t a = 0; a < LOW_NB; a++)
+        {
+            for (uint32_t b = 0; b < LOW_NB; b++)
+            {
+                table.low_correct[a * LOW_NB + b] = part_correct(a, b, LOW_SLOT_NB);
+            }
+        }
+
+        // Number the color multisets in order of first appearance
+        for (uint32_t code = 0; code < V::CODE_NB; code++)
+        {
+            uint8_t histogram[V::COLOR_NB]{};
+            for (uint8_t i = 0; i < V::SLOT_NB; i++)
+            {
+                histogram[V::digit(code, i)]++;
+            }
+
+            uint32_t id = 0;
+            for (; id < multiset_found; id++)
+            {
+                bool same = true;
+                for (uint8_t c = 0; c < V::COLOR_NB; c++)
+                {
+                    same = same && histograms[id][c] == histogram[c];
+                }
+                if (same)
+                {
+                    break;
+                }
+            }
+
+            if (id == multiset_found)
+            {
+                for (uint8_t c = 0; c < V::COLOR_NB; c++)
+                {
+                    histograms[id][c] = histogram[c];
+                }
+                multiset_found++;
+            }
+            table.multiset[code] = id;
+        }
+
+        for (uint32_t a = 0; a < MULTISET_NB; a++)
+        {
+            for (uint32_t b = 0; b < MULTISET_NB; b++)
+            {
+                uint8_t common = 0;
+                for (uint8_t c = 0; c < V::COLOR_NB; c++)
+                {
+                    common += histograms[a][c] < histograms[b][c] ? histograms[a][c] : histograms[b][c];
+                }
+                uint32_t pos = a * MULTISET_NB + b;
+                table.common[pos / 2] |= common << ((pos % 2) * 4);
+            }
+        }
+
+        return table;
+    }
+
+    /**
+     * @brief Score a guess against a secret, both given by their index.
+     *
+     * @return The correct and present clues, packed with V::clues_pack()
+     */
+    constexpr uint8_t score(uint32_t guess, uint32_t secret) const
+    {
+        uint8_t correct = high_correct[(guess / LOW_NB) * HIGH_NB + secret / LOW_NB] +
+                          low_correct[(guess % LOW_NB) * LOW_NB + secret % LOW_NB];
+        uint32_t pos = multiset[guess] * MULTISET_NB + multiset[secret];
+        uint8_t common = (this->common[pos / 2] >> ((pos % 2) * 4)) & 0x0F;
+
+        return V::clues_pack(correct, common - correct);
+    }
+};
+
+template <class V>
+inline constexpr clues_table<V> clues_lookup = clues_table<V>::generate();
+
+#endif
@@ -1,9 +1,11 @@
 #include <cstdint>
+#include <cstring>
 #include <zephyr/logging/log.h>
 #include <zephyr/random/random.h>
 
 #include "etl/array.h"
 #include "combination.hpp"
+#include "packed_combination.hpp"
 
 #define LOG_LEVEL 4
 
@@ -14,7 +16,8 @@ LOG_MODULE_REGISTER(combination);
  *
  * Resets all slots in the combination by calling unset_all().
  */
-combination::combination(void)
+template <class V>
+basic_combination<V>::basic_combination(void)
 {
 	unset_all();
 }
@@ -22,11 +25,12 @@ combination::combination(void)
 /**
  * @brief Randomly fill the combination slots.
  */
-void combination::random_fill(void)
+template <class V>
+void basic_combination<V>::random_fill(void)
 {
 	for (auto &slot : slots)
 	{
-		slot.value = static_cast<slot_value>(sys_rand8_get() % int(slot_value::SLOT_VAL_MAX));
+		slot.value = static_cast<slot_value>(sys_rand32_get() % V::COLOR_NB);
 		slot.set = true;
 	}
 }
@@ -34,7 +38,8 @@ void combination::random_fill(void)
 /**
  * @brief Unset all slots in the combination.
  */
-void combination::unset_all(void)
+template <class V>
+void basic_combination<V>::unset_all(void)
 {
 	for (auto &slot : slots)
 	{
@@ -51,7 +56,8 @@ void combination::unset_all(void)
  * @param index The index of the slot to set.
  * @param new_value The value to set in the given slot.
  */
-void combination::set_slot(int index, slot_value new_value)
+template <class V>
+void basic_combination<V>::set_slot(int index, slot_value new_value)
 {
 	slots[index].value = new_value;
 	slots[index].set = true;
@@ -64,7 +70,8 @@ void combination::set_slot(int index, slot_value new_value)
  *
  * @return The number of unset slots left after the operation.
  */
-int combination::set_slot_next(slot_value new_value)
+template <class V>
+int basic_combination<V>::set_slot_next(slot_value new_value)
 {
 	int slot_left = slots.size();
 
@@ -89,48 +96,36 @@ int combination::set_slot_next(slot_value new_value)
  *
  * @return True if all slots are correct, false otherwise
  */
-bool combination::compute_clues(combination code)
+template <class V>
+bool basic_combination<V>::compute_clues(const basic_combination &code)
 {
-	clues_correct = 0;
-	clues_present = 0;
+	uint8_t clues = clues_score<V>(index(), code.index());
 
-	// First loop for checking correct value and position
-	for (uint8_t i = 0; i < code.slots.size(); i++)
-	{
-		if (code.slots[i].value == slots[i].value)
-		{
-			clues_correct++;
-			code.slots[i].value = slot_value::SLOT_VAL_MAX;
-		}
-	}
+	clues_correct = V::clues_get_correct(clues);
+	clues_present = V::clues_get_present(clues);
 
-	// Second loop for checking correct value but wrong position
-	for (uint8_t i = 0; i < code.slots.size(); i++)
-	{
-		if (code.slots[i].value == slot_value::SLOT_VAL_MAX)
-		{
-			// Skip slot already used
-			continue;
-		}
+	LOG_INF("Correct : %d - Present : %d", clues_correct, clues_present);
+	return clues_correct == slots.size();
+}
 
-		for (uint8_t j = 0; j < slots.size(); j++)
-		{
-			if (code.slots[j].value == slot_value::SLOT_VAL_MAX)
-			{
-				// Skip slot already used
-				continue;
-			}
-
-			if (code.slots[j].value == slots[i].value)
-			{
-				clues_present++;
-				break;
-			}
-		}
+/**
+ * @brief Get the index of the combination in the code space.
+ *
+ * Slot 0 is the most significant digit, in base V::COLOR_NB.
+ *
+ * @return The index of the combination, between 0 and V::CODE_NB - 1.
+ */
+template <class V>
+uint32_t basic_combination<V>::index(void) const
+{
+	uint32_t index = 0;
+
+	for (const auto &slot : slots)
+	{
+		index = index * V::COLOR_NB + int(slot.value);
 	}
 
-	LOG_INF("Correct : %d - Present : %d", clues_correct, clues_present);
-	return clues_correct == slots.size();
+	return index;
 }
 
 /**
@@ -145,7 +140,8 @@ bool combination::compute_clues(combination code)
  *
  * @return A pointer to the end of the serialized data.
  */
-uint8_t *combination::serialize(uint8_t *buf)
+template <class V>
+uint8_t *basic_combination<V>::serialize(uint8_t *buf)
 {
 	memcpy(buf, slots.data(), sizeof(slots));
 	buf += sizeof(slots);
@@ -153,4 +149,6 @@ uint8_t *combination::serialize(uint8_t *buf)
 	buf += sizeof(clues_present);
 	memcpy(buf, &clues_correct, sizeof(clues_correct));
 	return buf + sizeof(clues_correct);
-}
\ No newline at end of file
+}
+
+template class basic_combination<game>;
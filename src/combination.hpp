@@ -1,11 +1,12 @@
 #ifndef COMBINATION_H
 #define COMBINATION_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include "etl/array.h"
-
-#define SLOT_NB 4
+#include "app_cfg.hpp"
+#include "game_variant.hpp"
 
 enum class slot_value : uint8_t
 {
@@ -15,7 +16,8 @@ enum class slot_value : uint8_t
     SLOT_VAL_4,
     SLOT_VAL_5,
     SLOT_VAL_6,
-    SLOT_VAL_MAX,
+    SLOT_VAL_7,
+    SLOT_VAL_8,
 };
 
 struct slot
@@ -24,19 +26,29 @@ struct slot
     bool set;
 };
 
-class combination
+template <class V>
+class basic_combination
 {
 
 public:
-    combination();
-    etl::array<slot, SLOT_NB> slots;
+    // Size of the combination once serialized
+    static constexpr size_t SERIALIZED_SIZE = sizeof(slot) * V::SLOT_NB + 2;
+
+    basic_combination();
+    etl::array<slot, V::SLOT_NB> slots;
     uint8_t clues_correct;
     uint8_t clues_present;
     void random_fill(void);
     void unset_all(void);
     void set_slot(int index, slot_value value);
     int set_slot_next(slot_value value);
-    bool compute_clues(combination code);
+    bool compute_clues(const basic_combination &code);
+    uint32_t index(void) const;
     uint8_t *serialize(uint8_t *buf);
 };
+
+// Game variant selected at build time
+using game = game_variant<GAME_SLOT_NB, GAME_COLOR_NB>;
+using combination = basic_combination<game>;
+
 #endif
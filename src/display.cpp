@@ -4,6 +4,7 @@
 #include <zephyr/drivers/auxdisplay.h>
 
 #include "display.hpp"
+#include "latency.hpp"
 
 #define LOG_LEVEL 4
 
@@ -43,11 +44,12 @@ bool display::show_number(uint8_t num)
     }
 
     sprintf(str, "%02u", num);
-    if (!auxdisplay_write(segment_display, (uint8_t *)str, strlen(str)))
+    if (auxdisplay_write(segment_display, (uint8_t *)str, strlen(str)) != 0)
     {
         LOG_ERR("Error: Cannot write to display");
         return false;
     }
+    latency_stage_done(LATENCY_STAGE_DISPLAY);
 
     return true;
 }
@@ -59,11 +61,12 @@ bool display::show_number(uint8_t num)
  */
 bool display::clear(void)
 {
-    if (!auxdisplay_clear(segment_display))
+    if (auxdisplay_clear(segment_display) != 0)
     {
         LOG_ERR("Error: Cannot write to display");
         return false;
     }
+    latency_stage_done(LATENCY_STAGE_DISPLAY);
 
     return true;
 }
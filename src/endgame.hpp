@@ -0,0 +1,303 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <cstdint>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "candidate_set.hpp"
+#include "packed_combination.hpp"
+#include "solver.hpp"
+#include "symmetry.hpp"
+#include "app_cfg.hpp"
+
+// Longest guess sequence searched below the first guess, which bounds the recursion and its stack
+#define ENDGAME_DEPTH_MAX 8
+
+struct endgame_result
+{
+    // Index of the guess to play
+    uint32_t guess;
+    // Sum over the candidates of the guesses needed to find them, this one included
+    uint32_t total;
+    // False if the budget expired before the search was exhaustive
+    bool complete;
+};
+
+/**
+ * @brief Exact codebreaker for small candidate sets.
+ *
+ * Minimizes the expected number of guesses, that is the sum over the
+ * candidates of the guesses needed to find each one of them. The game tree is
+ * searched depth first with branch and bound: a guess is abandoned as soon as
+ * the cost of its solved partitions, plus a lower bound of the others, reaches
+ * the best cost found so far.
+ *
+ * The lower bound of a set of n candidates assumes a perfect game: one
+ * candidate found by the next guess, then at most BRANCH_NB by the guess
+ * after it, then BRANCH_NB times more at each depth. BRANCH_NB is the number
+ * of clues a guess can get, correct + present <= SLOT_NB, but the win and
+ * correct = SLOT_NB - 1, present = 1: 13 for 4 slots.
+ *
+ * Guess sequences longer than ENDGAME_DEPTH_MAX are not searched, so the
+ * recursion depth stays bounded. With at most a few dozen candidates, the
+ * optimal strategies are far shorter.
+ *
+ * The candidates are kept in a single array: partitioning a range sorts it by
+ * clues, so each partition is a sub-range searched in place.
+ *
+ * @tparam CandidateMax Largest candidate set to search
+ */
+template <class V, uint8_t CandidateMax>
+class basic_endgame
+{
+public:
+    using index_t = typename V::index_t;
+
+    static constexpr uint32_t BRANCH_NB = (V::SLOT_NB + 1) * (V::SLOT_NB + 2) / 2 - 2;
+
+    /**
+     * @brief Search the guess with the lowest expected number of guesses.
+     *
+     * @param candidates Current candidate set, with at most CandidateMax candidates
+     * @param budget Time budget, the best guess found so far is returned when it expires
+     * @param symmetry Symmetries left by the history, to try one guess per equivalence class
+     */
+    endgame_result solve(const basic_candidate_set<V> &candidates, const solver_budget &budget,
+                         const basic_symmetry<V> *symmetry = nullptr)
+    {
+        uint8_t n = 0;
+
+        candidates.for_each([&](uint32_t index) { items[n++] = index; });
+        this->budget = &budget;
+        expired = false;
+
+        // The minimax guess is tried first, so it is the answer if the budget expires
+        solver_result seed = basic_solver<V>::minimax(candidates, solver_budget::unlimited(), symmetry);
+        endgame_result result = {seed.guess, UINT32_MAX, false};
+        result.total = search(0, n, UINT32_MAX, seed.guess, symmetry, &result.guess, 0);
+        result.complete = !expired;
+
+        return result;
+    }
+
+    /**
+     * @brief Lower bound of the guesses needed to find n candidates.
+     */
+    static uint32_t lower_bound(uint32_t n)
+    {
+        uint32_t total = 0;
+        uint32_t capacity = 1;
+
+        for (uint32_t depth = 1; n; depth++)
+        {
+            uint32_t found = n < capacity ? n : capacity;
+            total += found * depth;
+            n -= found;
+            capacity = depth == 1 ? BRANCH_NB : capacity * BRANCH_NB;
+        }
+
+        return total;
+    }
+
+private:
+    etl::array<index_t, CandidateMax> items;
+    etl::array<index_t, CandidateMax> sorted;
+    etl::array<uint8_t, CandidateMax> clues;
+    const solver_budget *budget;
+    bool expired;
+
+    void count(uint32_t guess, uint8_t begin, uint8_t n, etl::array<uint8_t, V::CLUES_NB> &counts)
+    {
+        counts.fill(0);
+        for (uint8_t i = 0; i < n; i++)
+        {
+            clues[i] = clues_score<V>(guess, items[begin + i]);
+            counts[clues[i]]++;
+        }
+    }
+
+    /**
+     * @brief Sort a range by the clues computed by the last call to count().
+     */
+    void sort(uint8_t begin, uint8_t n, const etl::array<uint8_t, V::CLUES_NB> &counts)
+    {
+        etl::array<uint8_t, V::CLUES_NB> offsets;
+        uint8_t offset = 0;
+
+        for (uint8_t c = 0; c < V::CLUES_NB; c++)
+        {
+            offsets[c] = offset;
+            offset += counts[c];
+        }
+        for (uint8_t i = 0; i < n; i++)
+        {
+            sorted[offsets[clues[i]]++] = items[begin + i];
+        }
+        for (uint8_t i = 0; i < n; i++)
+        {
+            items[begin + i] = sorted[i];
+        }
+    }
+
+    /**
+     * @brief Get the lowest candidate of a range from the given index, or V::CODE_NB.
+     */
+    uint32_t next_candidate(uint8_t begin, uint8_t n, uint32_t from) const
+    {
+        uint32_t next = V::CODE_NB;
+
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if (items[begin + i] >= from && items[begin + i] < next)
+            {
+                next = items[begin + i];
+            }
+        }
+
+        return next;
+    }
+
+    /**
+     * @brief Evaluate a guess on a range, if it can beat the bound.
+     *
+     * @param candidate False to skip the guess if it is a candidate
+     *
+     * @return The total number of guesses, or at least bound if it cannot beat it
+     */
+    uint32_t evaluate(uint32_t guess, uint8_t begin, uint8_t n, uint32_t bound, bool candidate, uint8_t depth)
+    {
+        etl::array<uint8_t, V::CLUES_NB> counts;
+        uint32_t remaining = 0;
+
+        count(guess, begin, n, counts);
+        if (!candidate && counts[V::CLUES_WIN])
+        {
+            return bound;
+        }
+        if (counts[V::CLUES_WIN] == 0 && counts[clues[0]] == n)
+        {
+            // No information from a guess which cannot win
+            return bound;
+        }
+
+        for (uint8_t c = 0; c < V::CLUES_NB; c++)
+        {
+            if (c != V::CLUES_WIN)
+            {
+                remaining += lower_bound(counts[c]);
+            }
+        }
+        if (n + remaining >= bound)
+        {
+            return bound;
+        }
+
+        sort(begin, n, counts);
+        uint32_t total = n;
+        uint8_t child = begin;
+        for (uint8_t c = 0; c < V::CLUES_NB; c++)
+        {
+            if (counts[c] == 0 || c == V::CLUES_WIN)
+            {
+                child += counts[c];
+                continue;
+            }
+
+            // What is left of the bound once the other partitions take their minimum
+            remaining -= lower_bound(counts[c]);
+            uint32_t cost =
+                search(child, counts[c], bound - total - remaining, V::CODE_NB, nullptr, nullptr, depth + 1);
+            total += cost;
+            if (expired || total + remaining >= bound)
+            {
+                return bound;
+            }
+            child += counts[c];
+        }
+
+        return total;
+    }
+
+    /**
+     * @brief Search the best guess for a range of candidates.
+     *
+     * @param first Guess to try first, or V::CODE_NB
+     * @param best_guess If not null, receives the best guess
+     * @param depth Number of guesses played before this one in the search
+     *
+     * @return The total number of guesses, or at least bound if it cannot beat it
+     */
+    uint32_t search(uint8_t begin, uint8_t n, uint32_t bound, uint32_t first, const basic_symmetry<V> *symmetry,
+                    uint32_t *best_guess, uint8_t depth)
+    {
+        if (n <= 2)
+        {
+            // Playing a candidate is optimal
+            if (best_guess)
+            {
+                *best_guess = items[begin];
+            }
+            return n == 1 ? 1 : 3;
+        }
+        if (lower_bound(n) >= bound || depth >= ENDGAME_DEPTH_MAX)
+        {
+            return bound;
+        }
+        if (budget->expired())
+        {
+            expired = true;
+            return bound;
+        }
+
+        uint32_t best = bound;
+        auto consider = [&](uint32_t guess, bool candidate) {
+            uint32_t cost = evaluate(guess, begin, n, best, candidate, depth);
+            if (cost < best)
+            {
+                best = cost;
+                if (best_guess)
+                {
+                    *best_guess = guess;
+                }
+            }
+            // Stop when the bound is reached, as no guess can do better
+            return !expired && best > lower_bound(n);
+        };
+
+        if (first != V::CODE_NB && !consider(first, true))
+        {
+            return best;
+        }
+
+        // Candidates first, as they can win at once. Evaluating a guess sorts the
+        // range, so they are taken by increasing index instead of by position.
+        for (uint32_t guess = next_candidate(begin, n, 0); guess != V::CODE_NB;
+             guess = next_candidate(begin, n, guess + 1))
+        {
+            if (guess != first && (!symmetry || symmetry->canonical(guess)) && !consider(guess, true))
+            {
+                return best;
+            }
+        }
+
+        // A guess which is not a candidate finds none of them, so it costs at least 2n
+        if (2 * n >= best)
+        {
+            return best;
+        }
+        for (uint32_t guess = 0; guess < V::CODE_NB; guess++)
+        {
+            if (guess != first && (!symmetry || symmetry->canonical(guess)) && !consider(guess, false))
+            {
+                return best;
+            }
+        }
+
+        return best;
+    }
+};
+
+using endgame = basic_endgame<game, ENDGAME_CANDIDATE_MAX>;
+
+#endif
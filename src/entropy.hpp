@@ -0,0 +1,109 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include <cstdint>
+
+/*
+ * Fixed-point log2 used to rank guesses by information gain, without libm
+ * and with the same results on every target.
+ *
+ * log2(n) = msb(n) + log2(1 + f), where f is the fraction of n below its most
+ * significant bit. log2(1 + f) is read from a table of ENTROPY_TABLE_SIZE + 1
+ * entries, generated at compile time, and linearly interpolated.
+ */
+
+#define ENTROPY_FRAC_BITS 16
+#define ENTROPY_TABLE_BITS 8
+#define ENTROPY_TABLE_SIZE (1 << ENTROPY_TABLE_BITS)
+
+/**
+ * @brief Natural logarithm of x > 0, for compile time evaluation only.
+ *
+ * Uses ln(x) = 2 * atanh((x - 1) / (x + 1)), which converges quickly for
+ * 1 <= x <= 2.
+ */
+constexpr double entropy_ln(double x)
+{
+    double y = (x - 1) / (x + 1);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0;
+
+    for (uint32_t k = 1; k < 64; k += 2)
+    {
+        sum += term / k;
+        term *= y2;
+    }
+
+    return 2 * sum;
+}
+
+struct entropy_table
+{
+    // log2(1 + i / ENTROPY_TABLE_SIZE), in ENTROPY_FRAC_BITS fixed point
+    uint32_t log2[ENTROPY_TABLE_SIZE + 1];
+
+    static constexpr entropy_table generate(void)
+    {
+        entropy_table table{};
+        const double ln2 = entropy_ln(2);
+
+        for (uint32_t i = 0; i <= ENTROPY_TABLE_SIZE; i++)
+        {
+            double value = entropy_ln(1 + double(i) / ENTROPY_TABLE_SIZE) / ln2;
+            table.log2[i] = uint32_t(value * (1 << ENTROPY_FRAC_BITS) + 0.5);
+        }
+
+        return table;
+    }
+};
+
+inline constexpr entropy_table entropy_log2_table = entropy_table::generate();
+
+/**
+ * @brief Base 2 logarithm of n >= 1, in ENTROPY_FRAC_BITS fixed point.
+ */
+constexpr uint32_t entropy_log2(uint32_t n)
+{
+    uint8_t msb = 31 - __builtin_clz(n);
+    uint32_t index = 0;
+    uint32_t interpolated = 0;
+
+    if (msb > ENTROPY_TABLE_BITS)
+    {
+        uint8_t shift = msb - ENTROPY_TABLE_BITS;
+        uint32_t rest = n & ((uint32_t(1) << shift) - 1);
+        index = (n >> shift) & (ENTROPY_TABLE_SIZE - 1);
+        interpolated = (uint64_t(entropy_log2_table.log2[index + 1] - entropy_log2_table.log2[index]) * rest) >> shift;
+    }
+    else
+    {
+        index = (n << (ENTROPY_TABLE_BITS - msb)) & (ENTROPY_TABLE_SIZE - 1);
+    }
+
+    return (uint32_t(msb) << ENTROPY_FRAC_BITS) + entropy_log2_table.log2[index] + interpolated;
+}
+
+/**
+ * @brief Sum of n * log2(n) over the partitions, in ENTROPY_FRAC_BITS fixed point.
+ *
+ * The entropy of a partition of N candidates is log2(N) - sum / N, so the
+ * guess with the lowest sum gives the most information.
+ */
+template <typename Array>
+constexpr uint64_t entropy_sum(const Array &partitions)
+{
+    uint64_t sum = 0;
+
+    for (uint32_t n : partitions)
+    {
+        if (n > 1)
+        {
+            sum += uint64_t(n) * entropy_log2(n);
+        }
+    }
+
+    return sum;
+}
+
+#endif
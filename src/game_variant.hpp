@@ -0,0 +1,82 @@
+#ifndef GAME_VARIANT_H
+#define GAME_VARIANT_H
+
+#include <cstdint>
+
+#include "etl/type_traits.h"
+
+constexpr uint32_t variant_pow(uint32_t base, uint8_t exp)
+{
+    return exp == 0 ? 1 : base * variant_pow(base, exp - 1);
+}
+
+constexpr uint32_t variant_binomial(uint32_t n, uint32_t k)
+{
+    return k == 0 ? 1 : variant_binomial(n - 1, k - 1) * n / k;
+}
+
+// Number of bits needed to store the given value
+constexpr uint8_t variant_bit_width(uint32_t value)
+{
+    return value == 0 ? 0 : 1 + variant_bit_width(value >> 1);
+}
+
+// Lowest bit of each of the count fields of the given width
+template <typename T>
+constexpr T variant_low_bits(uint8_t width, uint8_t count)
+{
+    return count == 0 ? 0 : (variant_low_bits<T>(width, count - 1) << width) | 1;
+}
+
+/**
+ * @brief Compile time description of a game variant.
+ *
+ * A combination is identified by its index in the code space: slot 0 is the
+ * most significant digit, in base COLOR_NB.
+ * Clues are packed in a single byte: correct * (SLOT_NB + 1) + present.
+ *
+ * @tparam SlotNb Number of slots in a combination
+ * @tparam ColorNb Number of colors for each slot
+ */
+template <uint8_t SlotNb, uint8_t ColorNb>
+struct game_variant
+{
+    static_assert(SlotNb >= 1 && ColorNb >= 2, "Invalid game variant");
+    static_assert(variant_bit_width(ColorNb) * SlotNb <= 32, "Code space must be indexable on 32 bits");
+
+    static constexpr uint8_t SLOT_NB = SlotNb;
+    static constexpr uint8_t COLOR_NB = ColorNb;
+    // Number of different combinations
+    static constexpr uint32_t CODE_NB = variant_pow(ColorNb, SlotNb);
+    // Number of different packed clues values
+    static constexpr uint8_t CLUES_NB = (SlotNb + 1) * (SlotNb + 1);
+    // Packed clues of a guessed combination
+    static constexpr uint8_t CLUES_WIN = SlotNb * (SlotNb + 1);
+
+    using index_t = typename etl::conditional<(CODE_NB <= UINT16_MAX + 1), uint16_t, uint32_t>::type;
+
+    static constexpr uint8_t clues_pack(uint8_t correct, uint8_t present)
+    {
+        return correct * (SlotNb + 1) + present;
+    }
+
+    static constexpr uint8_t clues_get_correct(uint8_t clues)
+    {
+        return clues / (SlotNb + 1);
+    }
+
+    static constexpr uint8_t clues_get_present(uint8_t clues)
+    {
+        return clues % (SlotNb + 1);
+    }
+
+    /**
+     * @brief Get the color of a slot from a combination index.
+     */
+    static constexpr uint8_t digit(uint32_t index, uint8_t slot)
+    {
+        return (index / variant_pow(ColorNb, SlotNb - 1 - slot)) % ColorNb;
+    }
+};
+
+#endif
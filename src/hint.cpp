@@ -0,0 +1,304 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "hint.hpp"
+#include "solver.hpp"
+#include "combination.hpp"
+#include "packed_combination.hpp"
+#include "ble.hpp"
+#include "opening_book.hpp"
+#include "analytics.hpp"
+
+// The endgame recursion takes 304 bytes per level with -Os on x86-64, ENDGAME_DEPTH_MAX levels at most.
+// Not measured on ARM yet: the "Hint stack" log of a debug.conf build gives the margin on a board.
+#define HINT_STACK 3072
+// Lowest priority: a search runs for up to its budget without yielding, and must not stall the melodies
+#define HINT_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+#define LOG_LEVEL 4
+
+LOG_MODULE_REGISTER(hint);
+
+K_THREAD_STACK_DEFINE(hintStack, HINT_STACK);
+hint::hint()
+{
+    k_sem_init(&requested, 0, 1);
+    k_mutex_init(&lock);
+    k_mutex_init(&cache_lock);
+    pending_publish = false;
+    searching_count = 0;
+    searching_publish = false;
+    prepared.count = 0;
+    stats_snapshot = {0, 0, 0};
+    threadId = k_thread_create(&kthread,
+                               hintStack,
+                               K_THREAD_STACK_SIZEOF(hintStack),
+                               hint::thread,
+                               this, NULL, NULL,
+                               HINT_PRIORITY, 0, K_NO_WAIT);
+}
+
+static uint32_t hint_clock(void)
+{
+    return k_uptime_get_32();
+}
+
+/**
+ * @brief Thread function for hints.
+ *
+ * Runs the search on the last requested candidate set, off the FSM thread, and
+ * keeps the result with the information it is expected to give. It is also
+ * published over BLE if a hint was requested for this set, before or during
+ * the search. Small
+ * candidate sets are solved exactly by the endgame solver within
+ * CONFIG_MASTERMIND_ENDGAME_BUDGET_MS, larger ones with HINT_STRATEGY within
+ * CONFIG_MASTERMIND_HINT_BUDGET_MS.
+ */
+void hint::thread(void *object, void *d1, void *d2)
+{
+    hint *hint_obj = reinterpret_cast<hint *>(object);
+    combination guess;
+
+    while (1)
+    {
+        k_sem_take(&hint_obj->requested, K_FOREVER);
+
+        k_mutex_lock(&hint_obj->lock, K_FOREVER);
+        hint_obj->working = hint_obj->pending;
+        bool publish = hint_obj->pending_publish;
+        hint_obj->pending_publish = false;
+        uint64_t fingerprint = partition_cache::fingerprint(hint_obj->working);
+        hint_obj->searching_fingerprint = fingerprint;
+        hint_obj->searching_count = hint_obj->working.count();
+        hint_obj->history.reset();
+        for (uint8_t i = 0; i < hint_obj->pending_try_nb; i++)
+        {
+            hint_obj->history.add(hint_obj->pending_tentatives[i].code.index());
+        }
+        k_mutex_unlock(&hint_obj->lock);
+
+        if (hint_obj->working.count() == 0)
+        {
+            LOG_ERR("No candidate left");
+            continue;
+        }
+
+        uint32_t start = k_uptime_get_32();
+        uint32_t hinted;
+        if (hint_obj->working.count() <= ENDGAME_CANDIDATE_MAX)
+        {
+            endgame_result result = hint_obj->exact.solve(
+                hint_obj->working, solver_budget::from_now(hint_clock, CONFIG_MASTERMIND_ENDGAME_BUDGET_MS),
+                &hint_obj->history);
+            if (result.total == UINT32_MAX)
+            {
+                LOG_INF("Hint %u is the minimax guess, budget expired before any guess was fully evaluated",
+                        result.guess);
+            }
+            else
+            {
+                LOG_INF("Hint %u needs %u guesses for %u candidates, found in %u ms%s", result.guess, result.total,
+                        hint_obj->working.count(), k_uptime_get_32() - start,
+                        result.complete ? "" : " (budget expired)");
+            }
+            hinted = result.guess;
+#if defined(CONFIG_INIT_STACKS) && defined(CONFIG_THREAD_STACK_INFO)
+            size_t unused;
+            if (k_thread_stack_space_get(k_current_get(), &unused) == 0)
+            {
+                LOG_DBG("Hint stack: %u of %u bytes never used", unused, HINT_STACK);
+            }
+#endif
+        }
+        else
+        {
+            solver_result result = hint_obj->search(hint_obj->working, CONFIG_MASTERMIND_HINT_BUDGET_MS,
+                                                    &hint_obj->history);
+            LOG_INF("Hint %u leaves %u candidates at most, found in %u ms%s", result.guess, result.worst,
+                    k_uptime_get_32() - start, result.complete ? "" : " (budget expired)");
+            hinted = result.guess;
+        }
+        uint32_t elapsed = k_uptime_get_32() - start;
+
+        etl::array<uint32_t, game::CLUES_NB> partitions;
+        solver::partition(hinted, hint_obj->working, partitions, UINT32_MAX);
+        uint16_t expected = analytics_expected<game>(partitions, hint_obj->working.count());
+
+        k_mutex_lock(&hint_obj->lock, K_FOREVER);
+        hint_obj->prepared = {fingerprint, hint_obj->working.count(), hinted, expected};
+        publish = publish || hint_obj->searching_publish;
+        hint_obj->searching_publish = false;
+        hint_obj->searching_count = 0;
+        k_mutex_unlock(&hint_obj->lock);
+
+        if (publish)
+        {
+            packed_combination::from_index(hinted).unpack(guess);
+            ble_update_hint(guess, hint_obj->working.count(), elapsed, hint_obj->cache_stats());
+        }
+    }
+}
+
+/**
+ * @brief Queue a candidate set for the hint thread.
+ *
+ * The candidate set is copied, so the caller can keep updating it. A hint to
+ * publish stays requested until the thread serves it, even if another set is
+ * prepared in the meantime: the hint is then the one of the newer set.
+ *
+ * A set the thread is already searching is not queued again. The running
+ * search serves the request, and an older set still queued is dropped.
+ */
+void hint::submit(const candidate_set &candidates, const etl::array<packed_tentative, MAX_TRY> &tentatives,
+                  uint8_t try_nb, bool publish)
+{
+    uint64_t fingerprint = partition_cache::fingerprint(candidates);
+
+    k_mutex_lock(&lock, K_FOREVER);
+    if (searching_count != 0 && searching_count == candidates.count() && searching_fingerprint == fingerprint)
+    {
+        searching_publish = searching_publish || pending_publish || publish;
+        pending_publish = false;
+        k_sem_reset(&requested);
+        k_mutex_unlock(&lock);
+        return;
+    }
+    pending = candidates;
+    pending_tentatives = tentatives;
+    pending_try_nb = try_nb;
+    pending_publish = pending_publish || publish;
+    k_mutex_unlock(&lock);
+    k_sem_give(&requested);
+}
+
+/**
+ * @brief Request a hint for the given candidate set.
+ *
+ * The hint is published at once when it was already prepared for this
+ * candidate set, or when the game still follows the opening book and more
+ * than ENDGAME_CANDIDATE_MAX candidates are left. Otherwise the candidate set
+ * is searched by the hint thread. A request made while the thread searches
+ * the same set is served by that search when it completes. A request for
+ * another set is searched after it.
+ *
+ * @param candidates The secrets still consistent with the clues.
+ * @param tentatives The tentatives played so far.
+ * @param try_nb The number of tentatives played.
+ */
+void hint::request(const candidate_set &candidates, const etl::array<packed_tentative, MAX_TRY> &tentatives,
+                   uint8_t try_nb)
+{
+    combination guess;
+    uint32_t ready;
+    uint16_t expected;
+
+    if (get_prepared(candidates, ready, expected))
+    {
+        LOG_INF("Hint %u already prepared", ready);
+        packed_combination::from_index(ready).unpack(guess);
+        ble_update_hint(guess, candidates.count(), 0, cache_stats());
+        return;
+    }
+
+    // The book holds minimax guesses, small sets are left to the endgame solver
+    uint32_t book = candidates.count() > ENDGAME_CANDIDATE_MAX ? opening_book_lookup(tentatives, try_nb)
+                                                               : OPENING_BOOK_MISS;
+    if (book != OPENING_BOOK_MISS)
+    {
+        LOG_INF("Hint %u read from the opening book", book);
+        packed_combination::from_index(book).unpack(guess);
+        ble_update_hint(guess, candidates.count(), 0, cache_stats());
+        return;
+    }
+
+    submit(candidates, tentatives, try_nb, true);
+}
+
+/**
+ * @brief Compute the hint of a candidate set in the background, without publishing it.
+ *
+ * Used after each tentative, so the analytics of the next one can compare it
+ * with the hint, and a hint requested later is published at once.
+ *
+ * @param candidates The secrets still consistent with the clues.
+ * @param tentatives The tentatives played so far.
+ * @param try_nb The number of tentatives played.
+ */
+void hint::prepare(const candidate_set &candidates, const etl::array<packed_tentative, MAX_TRY> &tentatives,
+                   uint8_t try_nb)
+{
+    submit(candidates, tentatives, try_nb, false);
+}
+
+/**
+ * @brief Get the hint prepared for a candidate set, if the thread already computed it.
+ *
+ * @param candidates The secrets still consistent with the clues.
+ * @param guess Receives the index of the hint.
+ * @param expected Receives the information expected from the hint, in 1/256 bit.
+ *
+ * @return true if the hint is ready, false otherwise.
+ */
+bool hint::get_prepared(const candidate_set &candidates, uint32_t &guess, uint16_t &expected)
+{
+    uint64_t fingerprint = partition_cache::fingerprint(candidates);
+    bool ready;
+
+    k_mutex_lock(&lock, K_FOREVER);
+    ready = prepared.count == candidates.count() && prepared.fingerprint == fingerprint;
+    if (ready)
+    {
+        guess = prepared.guess;
+        expected = prepared.expected;
+    }
+    k_mutex_unlock(&lock);
+
+    return ready;
+}
+
+/**
+ * @brief Search the best guess for a candidate set, through the partition cache.
+ *
+ * The cache is shared by the hints and the codebreaker mode, so it is locked
+ * during the search. A caller never waits for the search of the other one:
+ * while the cache is in use, the search runs without it.
+ *
+ * @param candidates The secrets still consistent with the clues.
+ * @param budget_ms The time budget of the search, on a cache miss.
+ * @param history The symmetries left by the tentatives, to skip the equivalent guesses.
+ */
+solver_result hint::search(const candidate_set &candidates, uint32_t budget_ms, const symmetry *history)
+{
+    solver_budget budget = solver_budget::from_now(hint_clock, budget_ms);
+
+    if (k_mutex_lock(&cache_lock, K_NO_WAIT) != 0)
+    {
+        LOG_DBG("Partition cache busy, searching without it");
+        return solver::search(HINT_STRATEGY, candidates, budget, history);
+    }
+
+    solver_result result = cache.search(HINT_STRATEGY, candidates, budget, history);
+    partition_cache_stats stats = cache.get_stats();
+    k_mutex_unlock(&cache_lock);
+
+    LOG_DBG("Partition cache: %u hits, %u misses, %u evictions", stats.hits, stats.misses, stats.evictions);
+    k_mutex_lock(&lock, K_FOREVER);
+    stats_snapshot = stats;
+    k_mutex_unlock(&lock);
+
+    return result;
+}
+
+/**
+ * @brief Get the partition cache counters, as of the end of the last cached search.
+ *
+ * They are a copy taken under the cache lock, so reading them never waits
+ * for a running search.
+ */
+partition_cache_stats hint::cache_stats(void)
+{
+    k_mutex_lock(&lock, K_FOREVER);
+    partition_cache_stats stats = stats_snapshot;
+    k_mutex_unlock(&lock);
+
+    return stats;
+}
@@ -0,0 +1,65 @@
+#ifndef HINT_H
+#define HINT_H
+
+#include <zephyr/kernel.h>
+
+#include "etl/array.h"
+#include "candidate_set.hpp"
+#include "packed_combination.hpp"
+#include "partition_cache.hpp"
+#include "solver.hpp"
+#include "symmetry.hpp"
+#include "endgame.hpp"
+#include "app_cfg.hpp"
+
+class hint
+{
+public:
+    hint();
+    void request(const candidate_set &candidates, const etl::array<packed_tentative, MAX_TRY> &tentatives,
+                 uint8_t try_nb);
+    void prepare(const candidate_set &candidates, const etl::array<packed_tentative, MAX_TRY> &tentatives,
+                 uint8_t try_nb);
+    bool get_prepared(const candidate_set &candidates, uint32_t &guess, uint16_t &expected);
+    solver_result search(const candidate_set &candidates, uint32_t budget_ms, const symmetry *history);
+    partition_cache_stats cache_stats(void);
+
+private:
+    // Last hint computed by the thread, and the candidate set it was computed for
+    struct prepared_hint
+    {
+        uint64_t fingerprint;
+        // Number of candidates, 0 if no hint was computed
+        uint32_t count;
+        uint32_t guess;
+        // Information expected from the hint, in 1/256 bit
+        uint16_t expected;
+    };
+
+    k_tid_t threadId;
+    struct k_thread kthread;
+    struct k_sem requested;
+    struct k_mutex lock;
+    candidate_set pending;
+    candidate_set working;
+    etl::array<packed_tentative, MAX_TRY> pending_tentatives;
+    uint8_t pending_try_nb;
+    bool pending_publish;
+    // Candidate set searched by the thread, count 0 when it is idle
+    uint64_t searching_fingerprint;
+    uint32_t searching_count;
+    // A hint was requested for the set being searched
+    bool searching_publish;
+    prepared_hint prepared;
+    symmetry history;
+    endgame exact;
+    struct k_mutex cache_lock;
+    partition_cache cache;
+    // Counters of the cache, copied under cache_lock and read under lock
+    partition_cache_stats stats_snapshot;
+    void submit(const candidate_set &candidates, const etl::array<packed_tentative, MAX_TRY> &tentatives,
+                uint8_t try_nb, bool publish);
+    static void thread(void *object, void *d1, void *d2);
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/devicetree.h>
+
+#include "etl/array.h"
+#include "latency.hpp"
+
+#define LOG_LEVEL 4
+
+LOG_MODULE_REGISTER(latency);
+
+// Delay between the GPIO edge of a press and its report, not included in the latencies
+#define LATENCY_DEBOUNCE_MS DT_PROP_OR(DT_NODELABEL(buttons), debounce_interval_ms, 0)
+
+// Recorded by the FSM thread, read by the BLE and shell threads
+static struct k_spinlock lock;
+static etl::array<latency_histogram, LATENCY_STAGE_NB> histograms;
+static uint32_t press_cycles;
+// Stages not reached yet since the last press, one bit each
+static uint8_t pending;
+
+void latency_press(uint32_t cycles)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    press_cycles = cycles;
+    pending = (1 << LATENCY_STAGE_NB) - 1;
+    k_spin_unlock(&lock, key);
+}
+
+void latency_stage_done(latency_stage stage)
+{
+    uint32_t now = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (pending & (1 << stage))
+    {
+        pending &= ~(1 << stage);
+        histograms[stage].record(k_cyc_to_us_floor32(now - press_cycles));
+    }
+    k_spin_unlock(&lock, key);
+}
+
+latency_summary latency_get(latency_stage stage)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    latency_summary summary = histograms[stage].summary();
+
+    k_spin_unlock(&lock, key);
+    return summary;
+}
+
+void latency_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    for (auto &histogram : histograms)
+    {
+        histogram.reset();
+    }
+    pending = 0;
+    k_spin_unlock(&lock, key);
+}
+
+#if defined(CONFIG_SHELL)
+
+static const char *const stage_names[LATENCY_STAGE_NB] = {"input", "leds", "display"};
+
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv)
+{
+    shell_print(sh, "%-8s %8s %8s %8s %8s %8s", "stage", "count", "min", "mean", "p99", "max");
+    for (uint8_t stage = 0; stage < LATENCY_STAGE_NB; stage++)
+    {
+        latency_summary s = latency_get(static_cast<latency_stage>(stage));
+        shell_print(sh, "%-8s %8u %8u %8u %8u %8u", stage_names[stage], s.count, s.min, s.mean, s.p99, s.max);
+    }
+    shell_print(sh, "Latencies in us from the debounced press, at %u Hz", sys_clock_hw_cycles_per_sec());
+    shell_print(sh, "Add the %u ms debounce interval for the latency from the GPIO edge", LATENCY_DEBOUNCE_MS);
+
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    latency_reset();
+    shell_print(sh, "Latency statistics cleared");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(latency_cmds,
+                               SHELL_CMD(show, NULL, "Show the press to feedback latencies", cmd_latency_show),
+                               SHELL_CMD(reset, NULL, "Clear the latency statistics", cmd_latency_reset),
+                               SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(latency, &latency_cmds, "Press to feedback latency statistics", NULL);
+
+#endif
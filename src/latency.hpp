@@ -0,0 +1,168 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "etl/array.h"
+
+/*
+ * Latency from a button press to each stage of its feedback, in microseconds.
+ * A press is timed when the gpio-keys driver reports it, after its debounce
+ * interval: the GPIO edge came LATENCY_DEBOUNCE_MS earlier.
+ *
+ * Each stage keeps a histogram with logarithmic buckets split in
+ * 2^LATENCY_SUB_BITS linear sub-buckets, so the p99 is known within 25%
+ * with a fixed amount of RAM. Latencies above 2^LATENCY_RANGE_BITS us fall in
+ * the last bucket, but are exact in the maximum and the mean.
+ */
+
+#define LATENCY_SUB_BITS 2
+#define LATENCY_RANGE_BITS 24
+#define LATENCY_BUCKET_NB ((LATENCY_RANGE_BITS - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+// Count, min, mean, p99 and max
+#define LATENCY_SERIALIZED_SIZE (5 * sizeof(uint32_t))
+
+enum latency_stage : uint8_t
+{
+    // The press is read by the FSM
+    LATENCY_STAGE_INPUT,
+    // The LED strip is updated
+    LATENCY_STAGE_LEDS,
+    // The 7-segment display is latched
+    LATENCY_STAGE_DISPLAY,
+    LATENCY_STAGE_NB
+};
+
+struct latency_summary
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t mean;
+    uint32_t p99;
+    uint32_t max;
+
+    /**
+     * @brief Serialize the summary in the byte order of the device.
+     *
+     * @return A pointer to the end of the serialized data.
+     */
+    uint8_t *serialize(uint8_t *buf) const
+    {
+        const uint32_t fields[] = {count, min, mean, p99, max};
+
+        memcpy(buf, fields, sizeof(fields));
+        return buf + sizeof(fields);
+    }
+};
+
+class latency_histogram
+{
+public:
+    latency_histogram(void)
+    {
+        reset();
+    }
+
+    void reset(void)
+    {
+        buckets.fill(0);
+        count = 0;
+        sum = 0;
+        min = UINT32_MAX;
+        max = 0;
+    }
+
+    void record(uint32_t us)
+    {
+        buckets[bucket(us)]++;
+        count++;
+        sum += us;
+        min = us < min ? us : min;
+        max = us > max ? us : max;
+    }
+
+    latency_summary summary(void) const
+    {
+        if (count == 0)
+        {
+            return {0, 0, 0, 0, 0};
+        }
+
+        // Highest latency of the bucket holding the sample of rank ceil(0.99 * count)
+        uint32_t rank = (uint64_t(count) * 99 + 99) / 100;
+        uint32_t seen = 0;
+        uint32_t p99 = max;
+        for (uint32_t i = 0; i < LATENCY_BUCKET_NB; i++)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                p99 = upper(i);
+                break;
+            }
+        }
+        p99 = p99 > max ? max : p99 < min ? min : p99;
+
+        return {count, min, uint32_t(sum / count), p99, max};
+    }
+
+    /**
+     * @brief Get the bucket of a latency: exact below 2^(LATENCY_SUB_BITS + 1),
+     * then the position of the most significant bit and the bits below it.
+     */
+    static uint32_t bucket(uint32_t us)
+    {
+        if (us >> LATENCY_RANGE_BITS)
+        {
+            return LATENCY_BUCKET_NB - 1;
+        }
+        if (us < (1 << LATENCY_SUB_BITS))
+        {
+            return us;
+        }
+
+        uint8_t msb = 31 - __builtin_clz(us);
+        uint8_t shift = msb - LATENCY_SUB_BITS;
+        return ((shift + 1) << LATENCY_SUB_BITS) + ((us >> shift) & ((1 << LATENCY_SUB_BITS) - 1));
+    }
+
+    /**
+     * @brief Get the highest latency of a bucket.
+     */
+    static uint32_t upper(uint32_t index)
+    {
+        if (index < (1 << LATENCY_SUB_BITS))
+        {
+            return index;
+        }
+
+        uint8_t shift = (index >> LATENCY_SUB_BITS) - 1;
+        uint32_t low = ((1 << LATENCY_SUB_BITS) + (index & ((1 << LATENCY_SUB_BITS) - 1))) << shift;
+        return low + (uint32_t(1) << shift) - 1;
+    }
+
+private:
+    etl::array<uint32_t, LATENCY_BUCKET_NB> buckets;
+    uint32_t count;
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+};
+
+/**
+ * @brief Start measuring the latency of a press.
+ *
+ * @param cycles Cycle counter when the press was reported
+ */
+void latency_press(uint32_t cycles);
+
+/**
+ * @brief Record the latency of the last press to a stage, once per press.
+ */
+void latency_stage_done(latency_stage stage);
+
+latency_summary latency_get(latency_stage stage);
+void latency_reset(void);
+
+#endif
@@ -6,7 +6,13 @@
 #include <zephyr/sys/util.h>
 
 #include "leds.hpp"
+#include "latency.hpp"
 
+#define LED_STACK 1024
+// Below the FSM, so it never waits on the strip, but above the hint search
+#define LED_PRIORITY (K_LOWEST_APPLICATION_THREAD_PRIO - 1)
+#define LED_ANIMATION_FPS 30
+#define LED_ANIMATION_BUDGET_US 1000
 #define LOG_LEVEL 4
 
 LOG_MODULE_REGISTER(leds);
@@ -21,9 +27,87 @@ static const struct led_rgb code_colors[] = {
     RGB(0x00, 0x0F, 0x00), // green
     RGB(0x00, 0x00, 0x0F), // blue
     RGB(0x0F, 0x0F, 0x00), // yellow
-    RGB(0x0F, 0x00, 0x0F)  // magenta
+    RGB(0x0F, 0x00, 0x0F), // magenta
+    RGB(0x00, 0x0F, 0x0F), // cyan
+    RGB(0x0F, 0x04, 0x00)  // orange
 };
 
+static_assert(ARRAY_SIZE(code_colors) >= game::COLOR_NB, "Missing LED color");
+static_assert(STRIP_NUM_LEDS >= 2 * game::SLOT_NB, "Strip needs one LED per slot and per clue");
+
+/**
+ * @brief Get the LEDs placement of the clues.
+ *
+ * The clues of the classic game are shown on a square:
+ * || 4 || 7 ||
+ * || 5 || 6 ||
+ * Other variants show the clues in order, after the combination.
+ */
+static constexpr etl::array<uint8_t, game::SLOT_NB> led_clues_index_generate(void)
+{
+    etl::array<uint8_t, game::SLOT_NB> index{};
+
+    for (uint8_t i = 0; i < game::SLOT_NB; i++)
+    {
+        index[i] = game::SLOT_NB + i;
+    }
+
+    if (game::SLOT_NB == 4)
+    {
+        index[1] = 7;
+        index[2] = 5;
+        index[3] = 6;
+    }
+
+    return index;
+}
+
+static constexpr etl::array<uint8_t, game::SLOT_NB> led_clues_index = led_clues_index_generate();
+
+K_THREAD_STACK_DEFINE(ledStack, LED_STACK);
+static struct k_work_q led_workq;
+
+static bool same_frame(const etl::array<struct led_rgb, STRIP_NUM_LEDS> &a,
+                       const etl::array<struct led_rgb, STRIP_NUM_LEDS> &b)
+{
+    for (uint8_t i = 0; i < STRIP_NUM_LEDS; i++)
+    {
+        if (a[i].r != b[i].r || a[i].g != b[i].g || a[i].b != b[i].b)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the rank of a LED in the target group of an animation.
+ *
+ * @return The slot of the LED for the combination and the clues, its position
+ * on the strip for the whole strip, or -1 if it is not in the group.
+ */
+static int8_t led_rank(uint8_t led, animation_target target)
+{
+    switch (target)
+    {
+    case animation_target::ANIMATION_CODE:
+        // Strip is reversed
+        return led < game::SLOT_NB ? game::SLOT_NB - 1 - led : -1;
+    case animation_target::ANIMATION_CLUES:
+        for (uint8_t i = 0; i < game::SLOT_NB; i++)
+        {
+            if (led_clues_index[i] == led)
+            {
+                return i;
+            }
+        }
+        return -1;
+    default:
+        return led;
+    }
+}
+
 /**
  * @brief Initialise the LEDs module.
  *
@@ -37,14 +121,22 @@ bool led_strip::init(void)
         LOG_ERR("Device is not ready");
         return false;
     }
+
+    front_valid = false;
+    anim = nullptr;
+    k_work_init(&work, push);
+    k_work_init(&frame_work, render);
+    k_timer_init(&timer, tick, NULL);
+    k_work_queue_start(&led_workq, ledStack, K_THREAD_STACK_SIZEOF(ledStack), LED_PRIORITY, NULL);
+    k_thread_name_set(&led_workq.thread, "leds");
     return true;
 }
 
 /**
  * @brief Update LEDs according to the given combination
  *
- * The first half of the strip is used to display the combination,
- * and the second half is used to display the clues.
+ * The first game::SLOT_NB LEDs of the strip are used to display the combination,
+ * and the next game::SLOT_NB LEDs are used to display the clues.
  *
  * @param combi The combination to be displayed
  */
@@ -54,7 +146,7 @@ void led_strip::update_combination(combination &combi)
 
     // Set combi LEDs
     // Strip is reversed so fill array starting by the end
-    for (uint8_t i = 0, led_index = 3; i < STRIP_NUM_LEDS / 2; i++, led_index--)
+    for (uint8_t i = 0, led_index = game::SLOT_NB - 1; i < game::SLOT_NB; i++, led_index--)
     {
         if (combi.slots[i].set)
         {
@@ -67,11 +159,7 @@ void led_strip::update_combination(combination &combi)
     }
 
     // Set clues LEDs
-    // LEDs placement and indexes :
-    // || 4 || 7 ||
-    // || 5 || 6 ||
-    const uint8_t led_clues_index[4] = {4, 7, 5, 6};
-    for (uint8_t i = 0; i < STRIP_NUM_LEDS / 2; i++)
+    for (uint8_t i = 0; i < game::SLOT_NB; i++)
     {
         if (i < combi.clues_correct)
         {
@@ -89,16 +177,186 @@ void led_strip::update_combination(combination &combi)
 }
 
 /**
- * @brief Refresh the LEDs on the strip
+ * @brief Write the front frame to the strip, in the LED work queue.
  */
-void led_strip::refresh(void)
+void led_strip::push(struct k_work *item)
 {
-    LOG_INF("Refreshing LEDs on strip");
-    int rc = led_strip_update_rgb(strip, leds.data(), STRIP_NUM_LEDS);
+    led_strip *obj = CONTAINER_OF(item, led_strip, work);
+    k_spinlock_key_t key = k_spin_lock(&obj->lock);
+
+    obj->frame = obj->front;
+    k_spin_unlock(&obj->lock, key);
+
+    int rc = led_strip_update_rgb(obj->strip, obj->frame.data(), STRIP_NUM_LEDS);
     if (rc)
     {
         LOG_ERR("Couldn't update strip: %d", rc);
+        // Send the next frame even if it is the same
+        key = k_spin_lock(&obj->lock);
+        obj->front_valid = false;
+        k_spin_unlock(&obj->lock, key);
+        return;
     }
+    atomic_inc(&obj->pushed);
+    latency_stage_done(LATENCY_STAGE_LEDS);
+}
+
+/**
+ * @brief Refresh the LEDs on the strip
+ *
+ * The frame is handed to the LED work queue, so the caller never waits for
+ * the strip. A frame equal to the last one is skipped, and a frame not
+ * written yet is replaced by the new one.
+ */
+void led_strip::refresh(void)
+{
+    stop();
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (front_valid && same_frame(front, leds))
+    {
+        k_spin_unlock(&lock, key);
+        atomic_inc(&skipped);
+        return;
+    }
+    front = leds;
+    front_valid = true;
+    k_spin_unlock(&lock, key);
+
+    LOG_DBG("Refreshing LEDs on strip");
+    if (k_work_submit_to_queue(&led_workq, &work) == 0)
+    {
+        // Still queued with the previous frame, which is never written
+        atomic_inc(&skipped);
+    }
+}
+
+/**
+ * @brief Wait until the last frame is written to the strip.
+ */
+void led_strip::sync(void)
+{
+    struct k_work_sync done;
+
+    k_work_flush(&work, &done);
+}
+
+/**
+ * @brief Ask for the next animation frame, from the timer interrupt.
+ */
+void led_strip::tick(struct k_timer *item)
+{
+    led_strip *obj = CONTAINER_OF(item, led_strip, timer);
+
+    if (k_work_submit_to_queue(&led_workq, &obj->frame_work) == 0)
+    {
+        // The previous frame is not rendered yet
+        atomic_inc(&obj->dropped);
+    }
+}
+
+/**
+ * @brief Render the animation frame of the current time, in the LED work queue.
+ *
+ * The frame is dropped if the previous one is still waiting for the strip,
+ * so a slow strip lowers the frame rate instead of delaying the animation.
+ */
+void led_strip::render(struct k_work *item)
+{
+    led_strip *obj = CONTAINER_OF(item, led_strip, frame_work);
+    uint32_t begin = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&obj->lock);
+
+    if (!obj->anim)
+    {
+        k_spin_unlock(&obj->lock, key);
+        return;
+    }
+    if (k_work_busy_get(&obj->work))
+    {
+        k_spin_unlock(&obj->lock, key);
+        atomic_inc(&obj->dropped);
+        return;
+    }
+
+    const animation &a = *obj->anim;
+    uint32_t t = k_uptime_get_32() - obj->anim_start;
+    int8_t rank_max = 0;
+    for (uint8_t i = 0; i < STRIP_NUM_LEDS; i++)
+    {
+        int8_t rank = led_rank(i, a.target);
+        if (rank < 0)
+        {
+            obj->front[i] = obj->base[i];
+            continue;
+        }
+
+        uint8_t level = a.level(int32_t(t) - int32_t(a.stagger) * rank);
+        animation_color color = a.effect == animation_effect::ANIMATION_HUE
+                                    ? animation_hue(level)
+                                    : animation_fade({obj->base[i].r, obj->base[i].g, obj->base[i].b}, level);
+        obj->front[i] = RGB(color.r, color.g, color.b);
+        rank_max = rank > rank_max ? rank : rank_max;
+    }
+    obj->front_valid = true;
+
+    // A non repeating animation stops once its last frame is rendered
+    bool over = !a.repeat && t >= a.length(rank_max);
+    if (over)
+    {
+        obj->anim = nullptr;
+    }
+    k_spin_unlock(&obj->lock, key);
+
+    if (over)
+    {
+        k_timer_stop(&obj->timer);
+    }
+    k_work_submit_to_queue(&led_workq, &obj->work);
+
+    if (k_cyc_to_us_floor32(k_cycle_get_32() - begin) > LED_ANIMATION_BUDGET_US)
+    {
+        atomic_inc(&obj->late);
+    }
+}
+
+/**
+ * @brief Start an animation from the current frame, replacing the running one.
+ *
+ * The frames are rendered at LED_ANIMATION_FPS by the LED work queue, until
+ * the animation is over or the next call to refresh(), reset() or stop().
+ *
+ * @param next The animation, which must outlive it
+ */
+void led_strip::animate(const animation &next)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    base = leds;
+    anim = &next;
+    anim_start = k_uptime_get_32();
+    k_spin_unlock(&lock, key);
+
+    k_timer_start(&timer, K_NO_WAIT, K_MSEC(1000 / LED_ANIMATION_FPS));
+}
+
+/**
+ * @brief Stop the running animation, leaving its last frame on the strip.
+ */
+void led_strip::stop(void)
+{
+    k_timer_stop(&timer);
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    anim = nullptr;
+    k_spin_unlock(&lock, key);
+}
+
+led_strip_stats led_strip::get_stats(void)
+{
+    return {(uint32_t)atomic_get(&pushed), (uint32_t)atomic_get(&skipped), (uint32_t)atomic_get(&dropped),
+            (uint32_t)atomic_get(&late)};
 }
 
 void led_strip::reset(void)
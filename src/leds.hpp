@@ -5,13 +5,27 @@
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/led_strip.h>
 #include <zephyr/device.h>
+#include <zephyr/sys/atomic.h>
 
 #include "etl/array.h"
 #include "combination.hpp"
+#include "animation.hpp"
 
-#define STRIP_NUM_LEDS 8
+#define STRIP_NUM_LEDS DT_PROP(DT_ALIAS(led_strip), chain_length)
 #define RGB(_r, _g, _b) {.r = (_r), .g = (_g), .b = (_b)}
 
+struct led_strip_stats
+{
+    // Frames written to the strip
+    uint32_t pushed;
+    // Frames unchanged, or replaced by a newer one before being written
+    uint32_t skipped;
+    // Animation frames dropped because the previous one was not written yet
+    uint32_t dropped;
+    // Animation frames rendered over their CPU budget
+    uint32_t late;
+};
+
 class led_strip
 {
 public:
@@ -19,10 +33,35 @@ public:
     void update_combination(combination &combi);
     void refresh(void);
     void reset(void);
+    void sync(void);
+    void animate(const animation &next);
+    void stop(void);
+    led_strip_stats get_stats(void);
 
 private:
     const struct device *const strip = DEVICE_DT_GET(DT_ALIAS(led_strip));
+    // Frame edited by the FSM
     etl::array<struct led_rgb, STRIP_NUM_LEDS> leds;
+    // Last frame handed to the work queue, valid once one was
+    etl::array<struct led_rgb, STRIP_NUM_LEDS> front;
+    bool front_valid;
+    // Copy of the front frame given to the driver, which may overwrite it
+    etl::array<struct led_rgb, STRIP_NUM_LEDS> frame;
+    struct k_spinlock lock;
+    struct k_work work;
+    atomic_t pushed;
+    atomic_t skipped;
+    // Running animation, or nullptr, and the frame it starts from
+    const animation *anim;
+    uint32_t anim_start;
+    etl::array<struct led_rgb, STRIP_NUM_LEDS> base;
+    struct k_timer timer;
+    struct k_work frame_work;
+    atomic_t dropped;
+    atomic_t late;
+    static void push(struct k_work *item);
+    static void tick(struct k_timer *item);
+    static void render(struct k_work *item);
 };
 
 #endif
@@ -8,11 +8,18 @@
 
 #include "etl/array.h"
 #include "combination.hpp"
+#include "packed_combination.hpp"
+#include "candidate_set.hpp"
+#include "solver.hpp"
+#include "symmetry.hpp"
 #include "leds.hpp"
 #include "buttons.hpp"
 #include "ble.hpp"
 #include "buzzer.hpp"
 #include "display.hpp"
+#include "hint.hpp"
+#include "opening_book.hpp"
+#include "analytics.hpp"
 #include "app_cfg.hpp"
 
 #define LOG_LEVEL 4
@@ -25,6 +32,9 @@ enum state
 	STATE_CHECK_INPUT,
 	STATE_CHECK_CMD,
 	STATE_CLUES,
+	STATE_BREAKER_SECRET,
+	STATE_BREAKER_GUESS,
+	STATE_BREAKER_SCORE,
 	STATE_END_WIN,
 	STATE_END_LOST,
 	STATE_OFF
@@ -34,19 +44,36 @@ static void state_start_run(void *o);
 static void state_check_input_run(void *o);
 static void state_check_cmd_run(void *o);
 static void state_clues_run(void *o);
+static void state_breaker_secret_run(void *o);
+static void state_breaker_guess_run(void *o);
+static void state_breaker_score_run(void *o);
 static void state_end_win_run(void *o);
 static void state_end_lost_run(void *o);
 static void state_off_run(void *o);
 
+static_assert(BUTTONS_NB >= game::COLOR_NB, "One button is needed per color");
+static_assert(BUTTONS_NB > game::SLOT_NB, "One button is needed per clues count");
+
 // FSM state variables
 static led_strip leds;
 static buzzer buzzer;
 static display display;
+static hint hint;
 static buttons buts;
 static combination code;
-static etl::array<combination, MAX_TRY> tentatives;
+static combination tentative;
+static etl::array<packed_tentative, MAX_TRY> tentatives;
+static candidate_set candidates;
+// Symmetries left by the tentatives, for the codebreaker searches
+static symmetry history;
 static uint8_t try_id;
+static guess_analytics analytics;
 static bool manual_mode;
+static game_mode mode;
+// State waiting for the buttons, resumed after checking the commands
+static enum state input_state;
+// Clues being entered by the player in codebreaker mode: 0 for correct, 1 for present
+static uint8_t score_step;
 static struct smf_ctx ctx;
 
 static const struct smf_state states[] = {
@@ -54,41 +81,221 @@ static const struct smf_state states[] = {
 	[STATE_CHECK_INPUT] = SMF_CREATE_STATE(NULL, state_check_input_run, NULL, NULL, NULL),
 	[STATE_CHECK_CMD] = SMF_CREATE_STATE(NULL, state_check_cmd_run, NULL, NULL, NULL),
 	[STATE_CLUES] = SMF_CREATE_STATE(NULL, state_clues_run, NULL, NULL, NULL),
+	[STATE_BREAKER_SECRET] = SMF_CREATE_STATE(NULL, state_breaker_secret_run, NULL, NULL, NULL),
+	[STATE_BREAKER_GUESS] = SMF_CREATE_STATE(NULL, state_breaker_guess_run, NULL, NULL, NULL),
+	[STATE_BREAKER_SCORE] = SMF_CREATE_STATE(NULL, state_breaker_score_run, NULL, NULL, NULL),
 	[STATE_END_WIN] = SMF_CREATE_STATE(NULL, state_end_win_run, NULL, NULL, NULL),
 	[STATE_END_LOST] = SMF_CREATE_STATE(NULL, state_end_lost_run, NULL, NULL, NULL),
 	[STATE_OFF] = SMF_CREATE_STATE(NULL, state_off_run, NULL, NULL, NULL),
 };
 
+/*
+ * Button events queued while a state runs: kept for the next input state, or
+ * dropped when they were made before the player could see what to answer.
+ */
+static const bool flush_buttons_after[] = {
+	[STATE_START] = true,
+	[STATE_CHECK_INPUT] = false,
+	[STATE_CHECK_CMD] = false,
+	// The next tentative can be typed while the clues are shown
+	[STATE_CLUES] = false,
+	[STATE_BREAKER_SECRET] = false,
+	// The clues of a guess cannot be entered while it is searched
+	[STATE_BREAKER_GUESS] = true,
+	[STATE_BREAKER_SCORE] = false,
+	[STATE_END_WIN] = true,
+	[STATE_END_LOST] = true,
+	[STATE_OFF] = false,
+};
+static_assert(ARRAY_SIZE(flush_buttons_after) == STATE_OFF + 1, "Every state needs a flush policy");
+
+/**
+ * @brief Check if the secret is chosen adaptively, instead of being fixed at start.
+ */
+static bool code_deferred(void)
+{
+	return mode == game_mode::GAME_MODE_EVIL && !manual_mode;
+}
+
+/**
+ * @brief Give the clues which keep the most candidates to the current tentative.
+ *
+ * The candidates are partitioned by the clues they would give, and the largest
+ * partition is kept. The winning clues are only given when no other one is left.
+ */
+static void evil_clues(void)
+{
+	etl::array<uint32_t, game::CLUES_NB> partitions;
+	uint8_t best = game::CLUES_WIN;
+
+	uint32_t start = k_cycle_get_32();
+	solver::partition(tentative.index(), candidates, partitions, UINT32_MAX);
+	for (uint8_t clues = 0; clues < game::CLUES_NB; clues++)
+	{
+		if (clues != game::CLUES_WIN && partitions[clues] >= partitions[best] &&
+			(best == game::CLUES_WIN || partitions[clues] > partitions[best]))
+		{
+			best = clues;
+		}
+	}
+	LOG_INF("Keeping %u candidates, partitioned in %u us", partitions[best],
+			k_cyc_to_us_floor32(k_cycle_get_32() - start));
+
+	tentative.clues_correct = game::clues_get_correct(best);
+	tentative.clues_present = game::clues_get_present(best);
+}
+
+/**
+ * @brief Measure the information given by the current tentative, before the candidates are pruned.
+ *
+ * One partition of the live candidates gives the expected and the gained
+ * information. The hint of the device was prepared in the background since
+ * the last tentative, and is only reported if it is ready.
+ */
+static void analyze_tentative(void)
+{
+	etl::array<uint32_t, game::CLUES_NB> partitions;
+	uint32_t best;
+	uint16_t best_expected;
+	uint8_t clues = game::clues_pack(tentative.clues_correct, tentative.clues_present);
+
+	uint32_t start = k_cycle_get_32();
+	solver::partition(tentative.index(), candidates, partitions, UINT32_MAX);
+	analytics.before = candidates.count();
+	analytics.gained = analytics_gained(candidates.count(), partitions[clues]);
+	analytics.expected = analytics_expected<game>(partitions, candidates.count());
+	if (hint.get_prepared(candidates, best, best_expected))
+	{
+		analytics.best_guess = best;
+		analytics.best_expected = best_expected;
+	}
+	else
+	{
+		analytics.best_guess = ANALYTICS_UNKNOWN_GUESS;
+		analytics.best_expected = ANALYTICS_UNKNOWN;
+	}
+	LOG_INF("Tentative expected %u/256 bits, gained %u/256 bits, hint %u/256 bits, analyzed in %u us",
+			analytics.expected, analytics.gained, analytics.best_expected,
+			k_cyc_to_us_floor32(k_cycle_get_32() - start));
+}
+
+/**
+ * @brief Record the current tentative, once its clues are known.
+ *
+ * Shows the clues, then analyzes the tentative, prunes the candidates and
+ * updates the game status.
+ *
+ * @param next_state State to go to if the game is not over.
+ *
+ * @return The next state of the FSM.
+ */
+static const struct smf_state *tentative_done(const struct smf_state *next_state)
+{
+	bool guessed = tentative.clues_correct == tentative.slots.size();
+
+	tentatives[try_id] = packed_tentative(tentative);
+	leds.update_combination(tentative);
+	// The clues pulse for 3 s, then the strip is left alone until the next tentative
+	leds.animate(animation_clues);
+	analyze_tentative();
+
+	uint32_t start = k_cycle_get_32();
+	candidates.prune(tentative.index(), tentatives[try_id++].clues);
+	history.add(tentative.index());
+	LOG_INF("%u candidates left, pruned in %u us", candidates.count(),
+			k_cyc_to_us_floor32(k_cycle_get_32() - start));
+
+	if (code_deferred())
+	{
+		// Any candidate left is consistent with all the clues given so far
+		packed_combination::from_index(candidates.first()).unpack(code);
+	}
+
+	buzzer.play_clues();
+	display.show_number(try_id + 1);
+
+	ble_update_status(tentatives, code, try_id, candidates.count(), analytics);
+
+	if (guessed)
+	{
+		return &states[STATE_END_WIN];
+	}
+	else if (try_id >= tentatives.size())
+	{
+		return &states[STATE_END_LOST];
+	}
+
+	if (input_state == STATE_CHECK_INPUT)
+	{
+		hint.prepare(candidates, tentatives, try_id);
+	}
+
+	return next_state;
+}
+
 static void state_start_run(void *o)
 {
 	try_id = 0;
-	tentatives[try_id].unset_all();
+	tentative.unset_all();
+	candidates.reset();
+	history.reset();
 	leds.reset();
 
-	if (!manual_mode)
+	if (mode == game_mode::GAME_MODE_CODEBREAKER)
 	{
-		// If manual mode is disabled, generate a random code
-		code.random_fill();
+		// The player enters the secret with the buttons
+		code.unset_all();
+		input_state = STATE_BREAKER_SECRET;
+	}
+	else
+	{
+		if (code_deferred())
+		{
+			// The code is only a placeholder until the clues force it
+			packed_combination::from_index(candidates.first()).unpack(code);
+		}
+		else if (!manual_mode)
+		{
+			// If manual mode is disabled, generate a random code
+			code.random_fill();
+		}
+		input_state = STATE_CHECK_INPUT;
 	}
 
+	button_stats stats = buts.get_stats();
+	led_strip_stats frames = leds.get_stats();
+	LOG_INF("Buttons: %u events, %u dropped", stats.events, stats.overflows);
+	LOG_INF("LED frames: %u pushed, %u skipped, %u animation frames dropped, %u late", frames.pushed,
+			frames.skipped, frames.dropped, frames.late);
+
 	display.show_number(1);
 	buzzer.play_start();
 
-	ble_update_status(tentatives, code, try_id);
+	analytics = guess_analytics::none();
+	ble_update_status(tentatives, code, try_id, candidates.count(), analytics);
+	if (input_state == STATE_CHECK_INPUT)
+	{
+		hint.prepare(candidates, tentatives, try_id);
+	}
 	smf_set_state(&ctx, &states[STATE_CHECK_CMD]);
 }
 
 static void state_check_cmd_run(void *o)
 {
-	etl::bitset<BT_COMMAND_COUNT> &cmds = ble_get_commands();
-	etl::array<uint8_t, BT_COMMAND_BUF_SIZE> &buf = ble_get_command_buf();
-	const struct smf_state *next_state = &states[STATE_CHECK_INPUT];
-	uint8_t pos = 0;
+	const struct smf_state *next_state = &states[input_state];
+	ble_command cmd;
+
+	// Reset before emptying the queue, a command queued meanwhile raises it again
+	k_poll_signal_reset(ble_get_command_signal());
 
-	while (cmds.any())
+	// Commands are executed in the order they were written
+	while (ble_pop_command(cmd))
 	{
-		pos = cmds.find_first(true);
-		switch (pos)
+		etl::array<uint8_t, BT_COMMAND_BUF_SIZE> &buf = cmd.payload;
+
+		LOG_DBG("Command %u executed %u us after its reception", cmd.id,
+				k_cyc_to_us_floor32(k_cycle_get_32() - cmd.received));
+		switch (cmd.id)
 		{
 		case BT_COMMAND_RESET:
 			LOG_INF("Executing 'Reset' command");
@@ -99,6 +306,10 @@ static void state_check_cmd_run(void *o)
 			LOG_INF("Executing 'Off' command");
 			next_state = &states[STATE_OFF];
 			break;
+		case BT_COMMAND_HINT:
+			LOG_INF("Executing 'Hint' command");
+			hint.request(candidates, tentatives, try_id);
+			break;
 		case BT_COMMAND_CODE:
 			LOG_INF("Executing 'Code' command");
 			manual_mode = true;
@@ -108,11 +319,23 @@ static void state_check_cmd_run(void *o)
 			}
 			next_state = &states[STATE_START];
 			break;
+		case BT_COMMAND_MODE:
+			LOG_INF("Executing 'Mode' command");
+			mode = static_cast<game_mode>(buf[0]);
+			manual_mode = false;
+			next_state = &states[STATE_START];
+			break;
+		case BT_COMMAND_FORMAT:
+			LOG_INF("Executing 'Format' command");
+			if (ble_set_status_format(buf[0]))
+			{
+				ble_update_status(tentatives, code, try_id, candidates.count(), analytics);
+			}
+			break;
 		default:
 			LOG_ERR("Unknown command");
 			break;
 		}
-		cmds.set(pos, false);
 	}
 
 	smf_set_state(&ctx, next_state);
@@ -121,7 +344,7 @@ static void state_check_cmd_run(void *o)
 static void state_check_input_run(void *o)
 {
 	uint8_t slot_left = 0;
-	button_val val = buts.wait_for_input(K_MSEC(1000));
+	button_val val = buts.wait_for_input(K_FOREVER, ble_get_command_signal());
 	switch (val)
 	{
 	case button_val::BUTTON_VAL_1:
@@ -130,8 +353,10 @@ static void state_check_input_run(void *o)
 	case button_val::BUTTON_VAL_4:
 	case button_val::BUTTON_VAL_5:
 	case button_val::BUTTON_VAL_6:
+	case button_val::BUTTON_VAL_7:
+	case button_val::BUTTON_VAL_8:
 		buzzer.play_button();
-		slot_left = tentatives[try_id].set_slot_next(static_cast<slot_value>(val));
+		slot_left = tentative.set_slot_next(static_cast<slot_value>(val));
 		break;
 	case button_val::BUTTON_VAL_NONE:
 		smf_set_state(&ctx, &states[STATE_CHECK_CMD]);
@@ -147,7 +372,7 @@ static void state_check_input_run(void *o)
 	}
 	else
 	{
-		leds.update_combination(tentatives[try_id]);
+		leds.update_combination(tentative);
 		leds.refresh();
 	}
 }
@@ -155,28 +380,134 @@ static void state_check_input_run(void *o)
 static void state_clues_run(void *o)
 {
 	LOG_INF("[Combi %d] All slot filled, showing clues", try_id);
-	bool guessed = tentatives[try_id].compute_clues(code);
-	leds.update_combination(tentatives[try_id++]);
-	leds.refresh();
+	if (code_deferred())
+	{
+		evil_clues();
+	}
+	else
+	{
+		tentative.compute_clues(code);
+	}
+	smf_set_state(&ctx, tentative_done(&states[STATE_CHECK_CMD]));
+	tentative.unset_all();
+}
 
-	buzzer.play_clues();
-	display.show_number(try_id + 1);
+static void state_breaker_secret_run(void *o)
+{
+	button_val val = buts.wait_for_input(K_FOREVER, ble_get_command_signal());
 
-	ble_update_status(tentatives, code, try_id);
+	if (val == button_val::BUTTON_VAL_NONE)
+	{
+		smf_set_state(&ctx, &states[STATE_CHECK_CMD]);
+		return;
+	}
 
-	if (guessed)
+	if (int(val) >= game::COLOR_NB)
 	{
-		smf_set_state(&ctx, &states[STATE_END_WIN]);
+		LOG_ERR("Unknown button pressed");
+		return;
 	}
-	else if (try_id >= tentatives.size())
+
+	buzzer.play_button();
+	int slot_left = code.set_slot_next(static_cast<slot_value>(val));
+	leds.update_combination(code);
+	leds.refresh();
+
+	if (slot_left == 0)
+	{
+		LOG_INF("Secret entered, starting to guess");
+		smf_set_state(&ctx, &states[STATE_BREAKER_GUESS]);
+	}
+}
+
+static void state_breaker_guess_run(void *o)
+{
+	if (candidates.count() == 0)
 	{
+		LOG_ERR("No candidate left");
 		smf_set_state(&ctx, &states[STATE_END_LOST]);
+		return;
+	}
+
+	uint32_t guess = opening_book_lookup(tentatives, try_id);
+	if (guess != OPENING_BOOK_MISS)
+	{
+		LOG_INF("[Combi %d] Playing %u from the opening book", try_id, guess);
 	}
 	else
 	{
-		tentatives[try_id].unset_all();
+		uint32_t start = k_uptime_get_32();
+		solver_result result = hint.search(candidates, CONFIG_MASTERMIND_BREAKER_BUDGET_MS, &history);
+		LOG_INF("[Combi %d] Playing %u, found in %u ms%s", try_id, result.guess, k_uptime_get_32() - start,
+				result.complete ? "" : " (budget expired)");
+		guess = result.guess;
+	}
+
+	tentative.unset_all();
+	packed_combination::from_index(guess).unpack(tentative);
+	leds.update_combination(tentative);
+	leds.refresh();
+
+	score_step = 0;
+	input_state = STATE_BREAKER_SCORE;
+	smf_set_state(&ctx, &states[STATE_CHECK_CMD]);
+}
+
+static void state_breaker_score_run(void *o)
+{
+	button_val val = buts.wait_for_input(K_FOREVER, ble_get_command_signal());
+
+	if (val == button_val::BUTTON_VAL_NONE)
+	{
 		smf_set_state(&ctx, &states[STATE_CHECK_CMD]);
+		return;
 	}
+
+	if (int(val) > game::SLOT_NB)
+	{
+		LOG_ERR("Unknown button pressed");
+		return;
+	}
+
+	// First button gives the correct clues count, second one the present clues count
+	buzzer.play_button();
+	if (score_step == 0)
+	{
+		tentative.clues_correct = int(val);
+		tentative.clues_present = 0;
+		score_step = 1;
+		leds.update_combination(tentative);
+		leds.refresh();
+		return;
+	}
+	tentative.clues_present = int(val);
+
+	// Check the clues against the secret, which the player may have misread
+	uint8_t clues = game::clues_pack(tentative.clues_correct, tentative.clues_present);
+	if (clues_score<game>(tentative.index(), code.index()) != clues)
+	{
+		LOG_WRN("Clues %d - %d are wrong, enter them again", tentative.clues_correct, tentative.clues_present);
+		buzzer.play_lose();
+		tentative.clues_correct = 0;
+		tentative.clues_present = 0;
+		score_step = 0;
+		leds.update_combination(tentative);
+		leds.refresh();
+		return;
+	}
+
+	smf_set_state(&ctx, tentative_done(&states[STATE_BREAKER_GUESS]));
+}
+
+/**
+ * @brief Wait until a BLE command is received, or the timeout expires.
+ */
+static void wait_for_command(k_timeout_t timeout)
+{
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+														 ble_get_command_signal());
+
+	k_poll(&event, 1, timeout);
 }
 
 static void state_end_win_run(void *o)
@@ -184,9 +515,10 @@ static void state_end_win_run(void *o)
 	LOG_INF("WIN !");
 	buzzer.play_win();
 	display.clear();
+	leds.animate(animation_win);
 
-	// Wait a bit to show the win message
-	k_sleep(K_SECONDS(5));
+	// Wait a bit to show the win message, a command ends the wait
+	wait_for_command(K_SECONDS(5));
 	manual_mode = false;
 	smf_set_state(&ctx, &states[STATE_START]);
 }
@@ -197,10 +529,10 @@ static void state_end_lost_run(void *o)
 	buzzer.play_lose();
 	display.clear();
 	leds.update_combination(code);
-	leds.refresh();
+	leds.animate(animation_reveal);
 
-	// Wait a bit to show the lose message
-	k_sleep(K_SECONDS(5));
+	// Wait a bit to show the lose message, a command ends the wait
+	wait_for_command(K_SECONDS(5));
 	manual_mode = false;
 	smf_set_state(&ctx, &states[STATE_START]);
 }
@@ -209,6 +541,7 @@ static void state_off_run(void *o)
 {
 	LOG_INF("Powering off");
 	leds.reset();
+	leds.sync();
 	sys_poweroff();
 }
 
@@ -239,12 +572,21 @@ int main(void)
 		return 1;
 	}
 
+	LOG_INF("Opening book: %u nodes, %u bytes", opening_book_node_nb(), opening_book_size());
+
 	manual_mode = false;
+	mode = game_mode::GAME_MODE_CLASSIC;
 	smf_set_initial(&ctx, &states[STATE_START]);
 
 	while (1)
 	{
+		const struct smf_state *current = ctx.current;
+
 		smf_run_state(&ctx);
+		if (flush_buttons_after[current - states])
+		{
+			buts.flush();
+		}
 	}
 
 	return 1;
@@ -0,0 +1,74 @@
+#include "opening_book.hpp"
+
+/*
+ * Minimax strategy tree generated on the host by tools/gen_book, when
+ * CONFIG_MASTERMIND_OPENING_BOOK is enabled. See gen_book.cpp for the layout.
+ */
+#ifdef CONFIG_MASTERMIND_OPENING_BOOK
+#include "opening_book_data.inc"
+
+static_assert(OPENING_BOOK_VERSION == 1, "Unsupported opening book version");
+static_assert(OPENING_BOOK_SLOT_NB == game::SLOT_NB && OPENING_BOOK_COLOR_NB == game::COLOR_NB,
+              "Opening book generated for another variant");
+#else
+#define OPENING_BOOK_NODE_NB 0
+#endif
+
+/**
+ * @brief Get the guess of the book for a game history.
+ *
+ * Walks down the tree with the code and the clues of each tentative. This is
+ * the guess the solver would play, found without any search.
+ *
+ * @param tentatives The tentatives played so far.
+ * @param try_nb The number of tentatives played.
+ *
+ * @return The index of the guess, or OPENING_BOOK_MISS if a tentative was not
+ * the one of the book, or if the book does not go that deep.
+ */
+uint32_t opening_book_lookup(const etl::array<packed_tentative, MAX_TRY> &tentatives, uint8_t try_nb)
+{
+#if OPENING_BOOK_NODE_NB
+    uint32_t node = 0;
+
+    for (uint8_t i = 0; i < try_nb; i++)
+    {
+        if (tentatives[i].code.index() != opening_book_guesses[node])
+        {
+            return OPENING_BOOK_MISS;
+        }
+
+        uint32_t child = opening_book_children[node];
+        while (child < opening_book_children[node + 1] && opening_book_clues[child] != tentatives[i].clues)
+        {
+            child++;
+        }
+        if (child == opening_book_children[node + 1])
+        {
+            return OPENING_BOOK_MISS;
+        }
+        node = child;
+    }
+
+    return opening_book_guesses[node];
+#else
+    return OPENING_BOOK_MISS;
+#endif
+}
+
+uint32_t opening_book_node_nb(void)
+{
+    return OPENING_BOOK_NODE_NB;
+}
+
+/**
+ * @brief Get the flash footprint of the book, in bytes.
+ */
+size_t opening_book_size(void)
+{
+#if OPENING_BOOK_NODE_NB
+    return sizeof(opening_book_guesses) + sizeof(opening_book_children) + sizeof(opening_book_clues);
+#else
+    return 0;
+#endif
+}
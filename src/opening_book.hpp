@@ -0,0 +1,18 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "etl/array.h"
+#include "packed_combination.hpp"
+#include "app_cfg.hpp"
+
+// Returned by opening_book_lookup() when the history leaves the book
+#define OPENING_BOOK_MISS game::CODE_NB
+
+uint32_t opening_book_lookup(const etl::array<packed_tentative, MAX_TRY> &tentatives, uint8_t try_nb);
+uint32_t opening_book_node_nb(void);
+size_t opening_book_size(void);
+
+#endif
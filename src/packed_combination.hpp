@@ -0,0 +1,218 @@
+#ifndef PACKED_COMBINATION_H
+#define PACKED_COMBINATION_H
+
+#include <cstdint>
+
+#include "etl/type_traits.h"
+#include "game_variant.hpp"
+#include "clues_table.hpp"
+#include "combination.hpp"
+
+/*
+ * Compact combination holding SLOT_NB slots of SLOT_BITS bits, slot 0 in the
+ * least significant bits. All slots are always set. The classic game fits
+ * in a uint16_t, with 3 bits per slot.
+ *
+ * Clues are computed with SWAR (SIMD within a register) operations:
+ * - Correct clues: the XOR of two codes has a null field for each matching slot.
+ * - Correct + present clues: sum of the per-color minimum of the histograms of
+ *   both codes, with one HISTOGRAM_BITS field per color.
+ */
+
+template <class V>
+class basic_packed_combination
+{
+public:
+    // A slot must hold a color, and the sum of the correct slots
+    static constexpr uint8_t SLOT_BITS = variant_bit_width(V::COLOR_NB - 1) > variant_bit_width(V::SLOT_NB)
+                                             ? variant_bit_width(V::COLOR_NB - 1)
+                                             : variant_bit_width(V::SLOT_NB);
+    // An histogram field holds a count of slots, and a guard bit
+    static constexpr uint8_t HISTOGRAM_BITS = variant_bit_width(V::SLOT_NB) + 1;
+
+    static_assert(V::SLOT_NB * SLOT_BITS <= 64, "Slots must fit in 64 bits");
+    static_assert(V::COLOR_NB * HISTOGRAM_BITS <= 64, "Histogram must fit in 64 bits");
+
+    using bits_t = typename etl::conditional<(V::SLOT_NB * SLOT_BITS <= 16), uint16_t,
+                                             typename etl::conditional<(V::SLOT_NB * SLOT_BITS <= 32), uint32_t, uint64_t>::type>::type;
+    using histogram_t = typename etl::conditional<(V::COLOR_NB * HISTOGRAM_BITS <= 32), uint32_t, uint64_t>::type;
+    // Type used for the multiplications, to avoid the promotion of uint16_t to int
+    using wide_t = typename etl::conditional<(sizeof(bits_t) < sizeof(uint32_t)), uint32_t, bits_t>::type;
+
+    static constexpr bits_t SLOT_MASK = (1 << SLOT_BITS) - 1;
+    static constexpr bits_t SLOT_LOW_BITS = variant_low_bits<bits_t>(SLOT_BITS, V::SLOT_NB);
+    static constexpr histogram_t HISTOGRAM_MASK = (1 << HISTOGRAM_BITS) - 1;
+    static constexpr histogram_t HISTOGRAM_LOW_BITS = variant_low_bits<histogram_t>(HISTOGRAM_BITS, V::COLOR_NB);
+    static constexpr histogram_t HISTOGRAM_HIGH_BITS = HISTOGRAM_LOW_BITS << (HISTOGRAM_BITS - 1);
+
+    bits_t bits;
+
+    constexpr basic_packed_combination(void) : bits(0) {}
+    constexpr explicit basic_packed_combination(bits_t packed) : bits(packed) {}
+
+    /**
+     * @brief Pack the slots of a combination, which must all be set.
+     */
+    explicit basic_packed_combination(const basic_combination<V> &combi) : bits(0)
+    {
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            bits |= bits_t(combi.slots[i].value) << (i * SLOT_BITS);
+        }
+    }
+
+    /**
+     * @brief Unpack the slots in the given combination, and set them all.
+     */
+    void unpack(basic_combination<V> &combi) const
+    {
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            combi.slots[i].value = get(i);
+            combi.slots[i].set = true;
+        }
+    }
+
+    /**
+     * @brief Build the packed combination of an index of the code space.
+     */
+    static constexpr basic_packed_combination from_index(uint32_t index)
+    {
+        basic_packed_combination packed;
+
+        for (uint8_t i = V::SLOT_NB; i-- > 0;)
+        {
+            packed.bits |= bits_t(index % V::COLOR_NB) << (i * SLOT_BITS);
+            index /= V::COLOR_NB;
+        }
+
+        return packed;
+    }
+
+    constexpr uint32_t index(void) const
+    {
+        uint32_t index = 0;
+
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            index = index * V::COLOR_NB + int(get(i));
+        }
+
+        return index;
+    }
+
+    constexpr slot_value get(uint8_t index) const
+    {
+        return static_cast<slot_value>((bits >> (index * SLOT_BITS)) & SLOT_MASK);
+    }
+
+    /**
+     * @brief Count each color of the combination, one field per color.
+     */
+    constexpr histogram_t histogram(void) const
+    {
+        histogram_t histogram = 0;
+
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            histogram += histogram_t(1) << (int(get(i)) * HISTOGRAM_BITS);
+        }
+
+        return histogram;
+    }
+
+    /**
+     * @brief Score this guess against a secret, without side effect.
+     *
+     * @param secret The secret combination
+     * @param guess_histogram Histogram of this combination
+     * @param secret_histogram Histogram of the secret combination
+     *
+     * @return The correct and present clues, packed with V::clues_pack()
+     */
+    constexpr uint8_t score(basic_packed_combination secret, histogram_t guess_histogram, histogram_t secret_histogram) const
+    {
+        // Reduce each slot of the XOR to its lowest bit, set if the slots differ
+        wide_t diff = bits ^ secret.bits;
+        wide_t diff_any = diff;
+        for (uint8_t i = 1; i < SLOT_BITS; i++)
+        {
+            diff_any |= diff >> i;
+        }
+        diff_any &= SLOT_LOW_BITS;
+        // Multiplying by the low bits sums all the slots in the highest one
+        uint8_t correct = V::SLOT_NB - (((diff_any * SLOT_LOW_BITS) >> ((V::SLOT_NB - 1) * SLOT_BITS)) & SLOT_MASK);
+
+        // Per field minimum, no borrow thanks to the guard bits
+        histogram_t guess_ge = (((guess_histogram | HISTOGRAM_HIGH_BITS) - secret_histogram) & HISTOGRAM_HIGH_BITS) >> (HISTOGRAM_BITS - 1);
+        histogram_t select = guess_ge * HISTOGRAM_MASK;
+        histogram_t common = (secret_histogram & select) | (guess_histogram & ~select);
+        // Multiplying by the low bits sums all the fields in the highest one
+        uint8_t total = ((common * HISTOGRAM_LOW_BITS) >> ((V::COLOR_NB - 1) * HISTOGRAM_BITS)) & HISTOGRAM_MASK;
+
+        return V::clues_pack(correct, total - correct);
+    }
+
+    constexpr uint8_t score(basic_packed_combination secret) const
+    {
+        return score(secret, histogram(), secret.histogram());
+    }
+
+    constexpr bool operator==(basic_packed_combination other) const
+    {
+        return bits == other.bits;
+    }
+};
+
+/**
+ * @brief Score a guess against a secret, both given by their index.
+ *
+ * Uses the clues lookup table when it is enabled for the variant, and the
+ * packed combinations otherwise. This function has no side effect and does
+ * not log anything, so it can be used to score whole candidate sets.
+ *
+ * @return The correct and present clues, packed with V::clues_pack()
+ */
+template <class V>
+constexpr uint8_t clues_score(uint32_t guess, uint32_t secret)
+{
+    if constexpr (clues_table<V>::ENABLED)
+    {
+        return clues_lookup<V>.score(guess, secret);
+    }
+    else
+    {
+        using packed = basic_packed_combination<V>;
+        return packed::from_index(guess).score(packed::from_index(secret));
+    }
+}
+
+/**
+ * @brief Compact history entry: a packed code and its packed clues.
+ */
+template <class V>
+struct basic_packed_tentative
+{
+    basic_packed_combination<V> code;
+    uint8_t clues;
+
+    constexpr basic_packed_tentative(void) : code(), clues(0) {}
+
+    explicit basic_packed_tentative(const basic_combination<V> &combi)
+        : code(combi), clues(V::clues_pack(combi.clues_correct, combi.clues_present)) {}
+
+    /**
+     * @brief Unpack the code and the clues in the given combination.
+     */
+    void unpack(basic_combination<V> &combi) const
+    {
+        code.unpack(combi);
+        combi.clues_correct = V::clues_get_correct(clues);
+        combi.clues_present = V::clues_get_present(clues);
+    }
+};
+
+using packed_combination = basic_packed_combination<game>;
+using packed_tentative = basic_packed_tentative<game>;
+
+#endif
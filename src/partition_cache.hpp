@@ -0,0 +1,178 @@
+#ifndef PARTITION_CACHE_H
+#define PARTITION_CACHE_H
+
+#include <cstdint>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "candidate_set.hpp"
+#include "solver.hpp"
+#include "app_cfg.hpp"
+
+/*
+ * Bounded cache of the solver results, keyed by a fingerprint of the
+ * candidate set. Different histories often leave the same candidates, which
+ * then get their guess without any search.
+ *
+ * The cache is 4-way set associative: the fingerprint selects a set, and
+ * each set evicts with its own clock hand, giving a second chance to the
+ * entries hit since the hand last passed. Only complete searches are stored,
+ * so a result cut by a time budget is never served again.
+ */
+
+#define PARTITION_CACHE_WAYS 4
+
+struct partition_cache_stats
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+};
+
+template <class V, uint32_t EntryNb>
+class basic_partition_cache
+{
+public:
+    static_assert(EntryNb >= PARTITION_CACHE_WAYS && EntryNb % PARTITION_CACHE_WAYS == 0,
+                  "Cache size must be a multiple of its ways");
+
+    static constexpr uint32_t SET_NB = EntryNb / PARTITION_CACHE_WAYS;
+
+    basic_partition_cache(void)
+    {
+        clear();
+    }
+
+    void clear(void)
+    {
+        for (auto &entry : entries)
+        {
+            entry.count = 0;
+            entry.referenced = false;
+        }
+        hands.fill(0);
+        stats = {0, 0, 0};
+    }
+
+    /**
+     * @brief Hash the candidates, with a 64-bit FNV-1a over the words of the set.
+     */
+    static uint64_t fingerprint(const basic_candidate_set<V> &candidates)
+    {
+        uint64_t hash = 0xcbf29ce484222325;
+
+        for (uint32_t w = 0; w < basic_candidate_set<V>::WORD_NB; w++)
+        {
+            hash = (hash ^ candidates.word(w)) * 0x100000001b3;
+        }
+
+        return hash;
+    }
+
+    /**
+     * @brief Search the result of a candidate set.
+     *
+     * @return True on a hit, with the result filled
+     */
+    bool lookup(const basic_candidate_set<V> &candidates, solver_result &result)
+    {
+        uint64_t hash = fingerprint(candidates);
+        uint32_t set = hash % SET_NB;
+
+        for (uint8_t way = 0; way < PARTITION_CACHE_WAYS; way++)
+        {
+            entry &e = entries[set * PARTITION_CACHE_WAYS + way];
+            if (e.count == candidates.count() && e.fingerprint == hash)
+            {
+                e.referenced = true;
+                result = {e.guess, e.worst, true};
+                stats.hits++;
+                return true;
+            }
+        }
+
+        stats.misses++;
+        return false;
+    }
+
+    /**
+     * @brief Store the result of a complete search.
+     */
+    void insert(const basic_candidate_set<V> &candidates, const solver_result &result)
+    {
+        uint64_t hash = fingerprint(candidates);
+        uint32_t set = hash % SET_NB;
+        uint8_t &hand = hands[set];
+
+        if (!result.complete)
+        {
+            return;
+        }
+
+        // Clock: skip the referenced entries once, clearing their bit
+        while (entries[set * PARTITION_CACHE_WAYS + hand].referenced)
+        {
+            entries[set * PARTITION_CACHE_WAYS + hand].referenced = false;
+            hand = (hand + 1) % PARTITION_CACHE_WAYS;
+        }
+
+        entry &e = entries[set * PARTITION_CACHE_WAYS + hand];
+        if (e.count)
+        {
+            stats.evictions++;
+        }
+        e = {hash, candidates.count(), result.guess, result.worst, false};
+        hand = (hand + 1) % PARTITION_CACHE_WAYS;
+    }
+
+    /**
+     * @brief Run the solver through the cache.
+     *
+     * The results are not keyed by strategy, so a cache must always be used
+     * with the same one.
+     */
+    solver_result search(solver_strategy strategy, const basic_candidate_set<V> &candidates,
+                         const solver_budget &budget, const basic_symmetry<V> *symmetry = nullptr)
+    {
+        solver_result result;
+
+        // The last two candidates are found without searching, and minimax knows its opening
+        if ((strategy == solver_strategy::SOLVER_MINIMAX && candidates.count() == V::CODE_NB) ||
+            candidates.count() <= 2)
+        {
+            return basic_solver<V>::search(strategy, candidates, budget, symmetry);
+        }
+
+        if (!lookup(candidates, result))
+        {
+            result = basic_solver<V>::search(strategy, candidates, budget, symmetry);
+            insert(candidates, result);
+        }
+
+        return result;
+    }
+
+    const partition_cache_stats &get_stats(void) const
+    {
+        return stats;
+    }
+
+private:
+    struct entry
+    {
+        uint64_t fingerprint;
+        // Number of candidates, 0 for an empty entry
+        uint32_t count;
+        uint32_t guess;
+        uint32_t worst;
+        bool referenced;
+    };
+
+    etl::array<entry, EntryNb> entries;
+    etl::array<uint8_t, SET_NB> hands;
+    partition_cache_stats stats;
+};
+
+using partition_cache = basic_partition_cache<game, PARTITION_CACHE_SIZE>;
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <cstdint>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "candidate_set.hpp"
+#include "symmetry.hpp"
+#include "entropy.hpp"
+
+// Clock used to bound the search time, in milliseconds
+typedef uint32_t (*solver_clock_t)(void);
+
+/**
+ * @brief Time budget of a search, which never expires without a clock.
+ */
+struct solver_budget
+{
+    solver_clock_t clock;
+    uint32_t deadline;
+
+    static solver_budget unlimited(void)
+    {
+        return {nullptr, 0};
+    }
+
+    static solver_budget from_now(solver_clock_t clock, uint32_t budget_ms)
+    {
+        return {clock, clock() + budget_ms};
+    }
+
+    bool expired(void) const
+    {
+        return clock && int32_t(clock() - deadline) >= 0;
+    }
+};
+
+enum class solver_strategy : uint8_t
+{
+    // Smallest worst-case partition
+    SOLVER_MINIMAX = 0,
+    // Largest expected information gain
+    SOLVER_ENTROPY,
+};
+
+struct solver_result
+{
+    // Index of the guess to play
+    uint32_t guess;
+    // Size of the largest candidate partition left by the guess
+    uint32_t worst;
+    // False if the budget expired before all the guesses were evaluated
+    bool complete;
+};
+
+/**
+ * @brief Knuth minimax and entropy codebreakers.
+ *
+ * Minimax plays the guess that minimizes the worst-case number of candidates
+ * left after its clues, entropy the guess whose clues give the most
+ * information on average. Ties are broken in favor of the candidates, which
+ * can win immediately, then of the lowest index.
+ */
+template <class V>
+class basic_solver
+{
+public:
+    /**
+     * @brief Precomputed first guess: half of the slots of color 1, half of color 2.
+     *
+     * This is Knuth's 1122 for the classic game, so no search is needed on the
+     * full code space.
+     */
+    static constexpr uint32_t opening(void)
+    {
+        uint32_t index = 0;
+
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            index = index * V::COLOR_NB + (i < V::SLOT_NB / 2 ? 0 : 1);
+        }
+
+        return index;
+    }
+
+    /**
+     * @brief Count the candidates left for each clues given to the guess.
+     *
+     * @param guess Index of the guess
+     * @param candidates Current candidate set
+     * @param partitions Number of candidates for each packed clues
+     * @param limit Stop counting as soon as a partition gets larger than limit
+     *
+     * @return The size of the largest partition, or limit + 1 if it was exceeded
+     */
+    static uint32_t partition(uint32_t guess, const basic_candidate_set<V> &candidates,
+                              etl::array<uint32_t, V::CLUES_NB> &partitions, uint32_t limit)
+    {
+        uint32_t worst = 0;
+
+        partitions.fill(0);
+        for (uint32_t w = 0; w < basic_candidate_set<V>::WORD_NB; w++)
+        {
+            uint32_t word = candidates.word(w);
+            while (word)
+            {
+                uint8_t bit = __builtin_ctz(word);
+                word &= word - 1;
+                uint32_t size = ++partitions[clues_score<V>(guess, w * 32 + bit)];
+                if (size > worst)
+                {
+                    worst = size;
+                    if (worst > limit)
+                    {
+                        return worst;
+                    }
+                }
+            }
+        }
+
+        return worst;
+    }
+
+    /**
+     * @brief Search the guess that minimizes the worst-case remaining candidates.
+     *
+     * @param candidates Current candidate set, which must not be empty
+     * @param budget Time budget, the best guess found so far is returned when it expires
+     * @param symmetry Symmetries left by the history, to score one guess per equivalence class
+     */
+    static solver_result minimax(const basic_candidate_set<V> &candidates, const solver_budget &budget,
+                                 const basic_symmetry<V> *symmetry = nullptr)
+    {
+        etl::array<uint32_t, V::CLUES_NB> partitions;
+        solver_result best = {candidates.first(), 0, true};
+        bool best_candidate = true;
+
+        if (candidates.count() == V::CODE_NB)
+        {
+            best.guess = opening();
+            best.worst = partition(best.guess, candidates, partitions, UINT32_MAX);
+            return best;
+        }
+
+        if (candidates.count() <= 2)
+        {
+            // Playing a candidate wins now or leaves a single one
+            best.worst = 1;
+            return best;
+        }
+
+        best.worst = partition(best.guess, candidates, partitions, UINT32_MAX);
+        for (uint32_t guess = 0; guess < V::CODE_NB; guess++)
+        {
+            if (budget.expired())
+            {
+                best.complete = false;
+                break;
+            }
+            if (symmetry && !symmetry->canonical(guess))
+            {
+                continue;
+            }
+
+            bool is_candidate = candidates.test(guess);
+            uint32_t worst = partition(guess, candidates, partitions, best.worst);
+            if (worst < best.worst || (worst == best.worst && is_candidate && !best_candidate))
+            {
+                best = {guess, worst, true};
+                best_candidate = is_candidate;
+            }
+        }
+
+        return best;
+    }
+
+    /**
+     * @brief Search the guess that maximizes the entropy of the partition.
+     *
+     * The entropy is computed in fixed point, so the guesses are ranked the
+     * same way on every target. Unlike minimax there is no precomputed
+     * opening: the full set is searched too, which is only fast with the
+     * symmetry reduction.
+     *
+     * @param candidates Current candidate set, which must not be empty
+     * @param budget Time budget, the best guess found so far is returned when it expires
+     * @param symmetry Symmetries left by the history, to score one guess per equivalence class
+     */
+    static solver_result entropy(const basic_candidate_set<V> &candidates, const solver_budget &budget,
+                                 const basic_symmetry<V> *symmetry = nullptr)
+    {
+        etl::array<uint32_t, V::CLUES_NB> partitions;
+        solver_result best = {candidates.first(), 0, true};
+        bool best_candidate = true;
+
+        if (candidates.count() <= 2)
+        {
+            // Playing a candidate wins now or leaves a single one
+            best.worst = 1;
+            return best;
+        }
+
+        best.worst = partition(best.guess, candidates, partitions, UINT32_MAX);
+        uint64_t best_sum = entropy_sum(partitions);
+        for (uint32_t guess = 0; guess < V::CODE_NB; guess++)
+        {
+            if (budget.expired())
+            {
+                best.complete = false;
+                break;
+            }
+            if (symmetry && !symmetry->canonical(guess))
+            {
+                continue;
+            }
+
+            bool is_candidate = candidates.test(guess);
+            uint32_t worst = partition(guess, candidates, partitions, UINT32_MAX);
+            uint64_t sum = entropy_sum(partitions);
+            if (sum < best_sum || (sum == best_sum && is_candidate && !best_candidate))
+            {
+                best = {guess, worst, true};
+                best_sum = sum;
+                best_candidate = is_candidate;
+            }
+        }
+
+        return best;
+    }
+
+    /**
+     * @brief Search the best guess with the given strategy.
+     */
+    static solver_result search(solver_strategy strategy, const basic_candidate_set<V> &candidates,
+                                const solver_budget &budget, const basic_symmetry<V> *symmetry = nullptr)
+    {
+        if (strategy == solver_strategy::SOLVER_ENTROPY)
+        {
+            return entropy(candidates, budget, symmetry);
+        }
+
+        return minimax(candidates, budget, symmetry);
+    }
+};
+
+using solver = basic_solver<game>;
+
+#endif
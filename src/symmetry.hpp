@@ -0,0 +1,219 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "combination.hpp"
+
+constexpr uint32_t variant_factorial(uint8_t n)
+{
+    return n <= 1 ? 1 : n * variant_factorial(n - 1);
+}
+
+/**
+ * @brief Symmetries of the game left by the tentatives played so far.
+ *
+ * A symmetry permutes the slots and relabels the colors so that every
+ * tentative is left unchanged. The clues are the same for the images of a
+ * guess and a secret, so the candidate set is preserved, and all the guesses
+ * of an equivalence class have the same partition sizes and are all
+ * candidates or not. The solver only needs to score one guess per class: the
+ * lowest index, which is the one it would keep on a tie.
+ *
+ * Colors never played are free, and can be relabeled at will. The slot
+ * permutations are kept with their mapping of the played colors, up to
+ * ELEMENT_MAX of them: with fewer elements some classes get more than one
+ * representative, which only costs time.
+ */
+template <class V>
+class basic_symmetry
+{
+public:
+    static constexpr uint32_t ELEMENT_MAX = variant_factorial(V::SLOT_NB) < 120 ? variant_factorial(V::SLOT_NB) : 120;
+    static constexpr uint8_t NO_COLOR = 0xFF;
+
+    basic_symmetry(void)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Forget the history: every slot permutation, every color free.
+     */
+    void reset(void)
+    {
+        etl::array<uint8_t, V::SLOT_NB> perm;
+
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            perm[i] = i;
+        }
+        used.fill(false);
+
+        element_nb = 0;
+        do
+        {
+            element &e = elements[element_nb++];
+            e.slot = perm;
+            e.color.fill(NO_COLOR);
+            e.inverse.fill(NO_COLOR);
+        } while (element_nb < ELEMENT_MAX && next_permutation(perm));
+    }
+
+    /**
+     * @brief Keep the symmetries leaving a new tentative unchanged.
+     *
+     * @param code Index of the tentative
+     */
+    void add(uint32_t code)
+    {
+        uint32_t kept = 0;
+
+        for (uint32_t n = 0; n < element_nb; n++)
+        {
+            element &e = elements[n];
+            bool valid = true;
+
+            // The color of slot i is mapped to the color of slot slot[i]
+            for (uint8_t i = 0; i < V::SLOT_NB && valid; i++)
+            {
+                uint8_t from = V::digit(code, i);
+                uint8_t to = V::digit(code, e.slot[i]);
+                if (e.color[from] == NO_COLOR && e.inverse[to] == NO_COLOR)
+                {
+                    e.color[from] = to;
+                    e.inverse[to] = from;
+                }
+                valid = e.color[from] == to;
+            }
+
+            if (valid)
+            {
+                elements[kept++] = e;
+            }
+        }
+        element_nb = kept;
+
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            used[V::digit(code, i)] = true;
+        }
+    }
+
+    /**
+     * @brief Check if a guess has the lowest index of its equivalence class.
+     */
+    bool canonical(uint32_t guess) const
+    {
+        etl::array<uint8_t, V::SLOT_NB> code;
+        etl::array<uint8_t, V::SLOT_NB> image;
+
+        for (uint8_t i = 0; i < V::SLOT_NB; i++)
+        {
+            code[i] = V::digit(guess, i);
+        }
+
+        for (uint32_t n = 0; n < element_nb; n++)
+        {
+            const element &e = elements[n];
+            etl::array<uint8_t, V::COLOR_NB> free_map;
+            uint8_t free_next = 0;
+
+            for (uint8_t i = 0; i < V::SLOT_NB; i++)
+            {
+                image[e.slot[i]] = used[code[i]] ? e.color[code[i]] : NO_COLOR - code[i];
+            }
+
+            // Relabel the free colors in order of appearance with the lowest free colors
+            free_map.fill(NO_COLOR);
+            uint32_t index = 0;
+            for (uint8_t i = 0; i < V::SLOT_NB; i++)
+            {
+                uint8_t color = image[i];
+                if (color > NO_COLOR - V::COLOR_NB)
+                {
+                    uint8_t &mapped = free_map[NO_COLOR - color];
+                    if (mapped == NO_COLOR)
+                    {
+                        while (used[free_next])
+                        {
+                            free_next++;
+                        }
+                        mapped = free_next++;
+                    }
+                    color = mapped;
+                }
+                index = index * V::COLOR_NB + color;
+            }
+
+            if (index < guess)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint32_t size(void) const
+    {
+        return element_nb;
+    }
+
+private:
+    struct element
+    {
+        // Destination slot of each slot
+        etl::array<uint8_t, V::SLOT_NB> slot;
+        // Relabeling of the played colors, and its inverse
+        etl::array<uint8_t, V::COLOR_NB> color;
+        etl::array<uint8_t, V::COLOR_NB> inverse;
+    };
+
+    etl::array<element, ELEMENT_MAX> elements;
+    uint32_t element_nb;
+    etl::array<bool, V::COLOR_NB> used;
+
+    /**
+     * @brief Step to the next permutation in lexicographic order.
+     *
+     * @return False after the last permutation
+     */
+    static bool next_permutation(etl::array<uint8_t, V::SLOT_NB> &perm)
+    {
+        int8_t i = V::SLOT_NB - 2;
+
+        while (i >= 0 && perm[i] >= perm[i + 1])
+        {
+            i--;
+        }
+        if (i < 0)
+        {
+            return false;
+        }
+
+        int8_t j = V::SLOT_NB - 1;
+        while (perm[j] <= perm[i])
+        {
+            j--;
+        }
+        uint8_t tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+
+        for (int8_t a = i + 1, b = V::SLOT_NB - 1; a < b; a++, b--)
+        {
+            tmp = perm[a];
+            perm[a] = perm[b];
+            perm[b] = tmp;
+        }
+
+        return true;
+    }
+};
+
+using symmetry = basic_symmetry<game>;
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef BATCH_SCORE_H
+#define BATCH_SCORE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_SCORE_X86
+#endif
+
+#include "game_variant.hpp"
+#include "packed_combination.hpp"
+
+/*
+ * Host kernel scoring one guess against a contiguous array of packed
+ * candidates, with the bits of basic_packed_combination in 32-bit lanes.
+ *
+ * It uses the same SWAR reduction as basic_packed_combination::score(), the
+ * histograms being replaced by per-color matches: XOR with a combination
+ * holding color c in every slot gives a null field for each slot of color c.
+ * - correct = matches(candidate ^ guess)
+ * - correct + present = sum, over the colors of the guess, of
+ *   min(count in the guess, matches(candidate ^ color))
+ * Each lane is independent, so the scalar, SSE4.2 and AVX2 versions give
+ * bit-identical clues. The implementation is selected at runtime.
+ */
+
+enum class batch_isa
+{
+	BATCH_ISA_SCALAR,
+	BATCH_ISA_SSE42,
+	BATCH_ISA_AVX2,
+};
+
+static inline const char *batch_isa_name(batch_isa isa)
+{
+	switch (isa)
+	{
+	case batch_isa::BATCH_ISA_AVX2:
+		return "avx2";
+	case batch_isa::BATCH_ISA_SSE42:
+		return "sse4.2";
+	default:
+		return "scalar";
+	}
+}
+
+/**
+ * @brief Get the best implementation supported by the CPU.
+ */
+static inline batch_isa batch_isa_detect(void)
+{
+#ifdef BATCH_SCORE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return batch_isa::BATCH_ISA_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.2"))
+	{
+		return batch_isa::BATCH_ISA_SSE42;
+	}
+#endif
+	return batch_isa::BATCH_ISA_SCALAR;
+}
+
+template <class V>
+class batch_score
+{
+public:
+	using packed = basic_packed_combination<V>;
+
+	static_assert(V::SLOT_NB * packed::SLOT_BITS <= 32, "Packed combinations must fit in 32-bit lanes");
+
+	static constexpr uint32_t LOW_BITS = variant_low_bits<uint32_t>(packed::SLOT_BITS, V::SLOT_NB);
+	static constexpr uint32_t FIELD_MASK = (1 << packed::SLOT_BITS) - 1;
+	static constexpr uint8_t TOP_SHIFT = (V::SLOT_NB - 1) * packed::SLOT_BITS;
+
+	/**
+	 * @brief Prepare the scoring of a guess.
+	 */
+	explicit batch_score(uint32_t guess) : guess(packed::from_index(guess).bits), color_nb(0)
+	{
+		packed code = packed::from_index(guess);
+
+		for (uint8_t i = 0; i < V::SLOT_NB; i++)
+		{
+			uint8_t color = uint8_t(code.get(i));
+			uint8_t c = 0;
+			while (c < color_nb && colors[c] != color * LOW_BITS)
+			{
+				c++;
+			}
+			if (c == color_nb)
+			{
+				colors[color_nb] = color * LOW_BITS;
+				counts[color_nb++] = 0;
+			}
+			counts[c]++;
+		}
+	}
+
+	/**
+	 * @brief Score the guess against count packed candidates.
+	 *
+	 * @param candidates Bits of the packed candidates
+	 * @param count Number of candidates
+	 * @param histogram Incremented for the packed clues of each candidate, V::CLUES_NB entries
+	 * @param clues If not null, receives the packed clues of each candidate
+	 */
+	void run(batch_isa isa, const uint32_t *candidates, size_t count, uint32_t *histogram, uint8_t *clues) const
+	{
+		size_t done = 0;
+
+#ifdef BATCH_SCORE_X86
+		if (isa == batch_isa::BATCH_ISA_AVX2)
+		{
+			done = run_avx2(candidates, count, histogram, clues);
+		}
+		else if (isa == batch_isa::BATCH_ISA_SSE42)
+		{
+			done = run_sse42(candidates, count, histogram, clues);
+		}
+#endif
+		for (size_t i = done; i < count; i++)
+		{
+			uint8_t score = score_scalar(candidates[i]);
+			histogram[score]++;
+			if (clues)
+			{
+				clues[i] = score;
+			}
+		}
+	}
+
+	uint8_t score_scalar(uint32_t candidate) const
+	{
+		uint32_t correct = matches(candidate ^ guess);
+		uint32_t total = 0;
+
+		for (uint8_t c = 0; c < color_nb; c++)
+		{
+			uint32_t same = matches(candidate ^ colors[c]);
+			total += same < counts[c] ? same : counts[c];
+		}
+
+		return correct * V::SLOT_NB + total;
+	}
+
+private:
+	uint32_t guess;
+	uint8_t color_nb;
+	// Distinct colors of the guess, repeated in every slot, and their count in the guess
+	uint32_t colors[V::SLOT_NB];
+	uint32_t counts[V::SLOT_NB];
+
+	static uint32_t matches(uint32_t diff)
+	{
+		uint32_t any = diff;
+
+		for (uint8_t i = 1; i < packed::SLOT_BITS; i++)
+		{
+			any |= diff >> i;
+		}
+		any &= LOW_BITS;
+
+		return V::SLOT_NB - (((any * LOW_BITS) >> TOP_SHIFT) & FIELD_MASK);
+	}
+
+#ifdef BATCH_SCORE_X86
+	__attribute__((target("avx2"))) static __m256i matches_avx2(__m256i diff)
+	{
+		__m256i any = diff;
+
+		for (uint8_t i = 1; i < packed::SLOT_BITS; i++)
+		{
+			any = _mm256_or_si256(any, _mm256_srl_epi32(diff, _mm_cvtsi32_si128(i)));
+		}
+		any = _mm256_and_si256(any, _mm256_set1_epi32(LOW_BITS));
+		any = _mm256_mullo_epi32(any, _mm256_set1_epi32(LOW_BITS));
+		any = _mm256_and_si256(_mm256_srl_epi32(any, _mm_cvtsi32_si128(TOP_SHIFT)), _mm256_set1_epi32(FIELD_MASK));
+
+		return _mm256_sub_epi32(_mm256_set1_epi32(V::SLOT_NB), any);
+	}
+
+	__attribute__((target("avx2"))) size_t run_avx2(const uint32_t *candidates, size_t count, uint32_t *histogram,
+													 uint8_t *clues) const
+	{
+		const __m256i guess_v = _mm256_set1_epi32(guess);
+		const __m256i slot_nb_v = _mm256_set1_epi32(V::SLOT_NB);
+		alignas(32) uint32_t scores[8];
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i code = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(candidates + i));
+			__m256i correct = matches_avx2(_mm256_xor_si256(code, guess_v));
+			__m256i total = _mm256_setzero_si256();
+
+			for (uint8_t c = 0; c < color_nb; c++)
+			{
+				__m256i same = matches_avx2(_mm256_xor_si256(code, _mm256_set1_epi32(colors[c])));
+				total = _mm256_add_epi32(total, _mm256_min_epu32(same, _mm256_set1_epi32(counts[c])));
+			}
+
+			_mm256_store_si256(reinterpret_cast<__m256i *>(scores),
+							   _mm256_add_epi32(_mm256_mullo_epi32(correct, slot_nb_v), total));
+			for (uint8_t l = 0; l < 8; l++)
+			{
+				histogram[scores[l]]++;
+			}
+			if (clues)
+			{
+				for (uint8_t l = 0; l < 8; l++)
+				{
+					clues[i + l] = scores[l];
+				}
+			}
+		}
+
+		return i;
+	}
+
+	__attribute__((target("sse4.2"))) static __m128i matches_sse42(__m128i diff)
+	{
+		__m128i any = diff;
+
+		for (uint8_t i = 1; i < packed::SLOT_BITS; i++)
+		{
+			any = _mm_or_si128(any, _mm_srl_epi32(diff, _mm_cvtsi32_si128(i)));
+		}
+		any = _mm_and_si128(any, _mm_set1_epi32(LOW_BITS));
+		any = _mm_mullo_epi32(any, _mm_set1_epi32(LOW_BITS));
+		any = _mm_and_si128(_mm_srl_epi32(any, _mm_cvtsi32_si128(TOP_SHIFT)), _mm_set1_epi32(FIELD_MASK));
+
+		return _mm_sub_epi32(_mm_set1_epi32(V::SLOT_NB), any);
+	}
+
+	__attribute__((target("sse4.2"))) size_t run_sse42(const uint32_t *candidates, size_t count, uint32_t *histogram,
+														uint8_t *clues) const
+	{
+		const __m128i guess_v = _mm_set1_epi32(guess);
+		const __m128i slot_nb_v = _mm_set1_epi32(V::SLOT_NB);
+		alignas(16) uint32_t scores[4];
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i code = _mm_loadu_si128(reinterpret_cast<const __m128i *>(candidates + i));
+			__m128i correct = matches_sse42(_mm_xor_si128(code, guess_v));
+			__m128i total = _mm_setzero_si128();
+
+			for (uint8_t c = 0; c < color_nb; c++)
+			{
+				__m128i same = matches_sse42(_mm_xor_si128(code, _mm_set1_epi32(colors[c])));
+				total = _mm_add_epi32(total, _mm_min_epu32(same, _mm_set1_epi32(counts[c])));
+			}
+
+			_mm_store_si128(reinterpret_cast<__m128i *>(scores),
+							_mm_add_epi32(_mm_mullo_epi32(correct, slot_nb_v), total));
+			for (uint8_t l = 0; l < 4; l++)
+			{
+				histogram[scores[l]]++;
+			}
+			if (clues)
+			{
+				for (uint8_t l = 0; l < 4; l++)
+				{
+					clues[i + l] = scores[l];
+				}
+			}
+		}
+
+		return i;
+	}
+#endif
+};
+
+#endif
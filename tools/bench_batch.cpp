@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "game_variant.hpp"
+#include "packed_combination.hpp"
+#include "batch_score.hpp"
+
+/*
+ * Host benchmark of the batch scoring kernel: scores BENCH_GUESS_NB guesses
+ * against the whole code space with each implementation supported by the
+ * CPU, and checks the clues of every candidate against clues_score(), the
+ * function used by combination::compute_clues().
+ */
+
+#define BENCH_GUESS_NB 16
+
+template <class V>
+static bool bench(batch_isa best)
+{
+	using clock = std::chrono::steady_clock;
+	using packed = basic_packed_combination<V>;
+	std::vector<uint32_t> candidates(V::CODE_NB);
+	std::vector<uint8_t> expected(V::CODE_NB);
+	std::vector<uint8_t> clues(V::CODE_NB);
+	bool identical = true;
+
+	printf("Variant %u slots x %u colors, %u candidates\n", V::SLOT_NB, V::COLOR_NB, V::CODE_NB);
+	for (uint32_t i = 0; i < V::CODE_NB; i++)
+	{
+		candidates[i] = packed::from_index(i).bits;
+	}
+
+	for (int isa = int(batch_isa::BATCH_ISA_SCALAR); isa <= int(best); isa++)
+	{
+		double elapsed_s = 0;
+
+		for (uint32_t g = 0; g < BENCH_GUESS_NB; g++)
+		{
+			uint32_t guess = uint64_t(g) * V::CODE_NB / BENCH_GUESS_NB + g;
+			uint32_t histogram[V::CLUES_NB] = {};
+			batch_score<V> scorer(guess);
+
+			auto start = clock::now();
+			scorer.run(batch_isa(isa), candidates.data(), V::CODE_NB, histogram, clues.data());
+			elapsed_s += std::chrono::duration<double>(clock::now() - start).count();
+
+			uint32_t expected_histogram[V::CLUES_NB] = {};
+			for (uint32_t i = 0; i < V::CODE_NB; i++)
+			{
+				expected[i] = clues_score<V>(guess, i);
+				expected_histogram[expected[i]]++;
+			}
+			for (uint32_t i = 0; i < V::CODE_NB; i++)
+			{
+				identical = identical && clues[i] == expected[i];
+			}
+			for (uint8_t c = 0; c < V::CLUES_NB; c++)
+			{
+				identical = identical && histogram[c] == expected_histogram[c];
+			}
+		}
+
+		printf("  %-7s %8.1f M candidates/s\n", batch_isa_name(batch_isa(isa)),
+			   double(V::CODE_NB) * BENCH_GUESS_NB / elapsed_s / 1e6);
+	}
+
+	printf("  %s\n", identical ? "identical to clues_score()" : "MISMATCH with clues_score()");
+
+	return identical;
+}
+
+int main(void)
+{
+	batch_isa best = batch_isa_detect();
+	bool identical = true;
+
+	printf("Best implementation: %s\n", batch_isa_name(best));
+	identical = bench<game_variant<4, 6>>(best) && identical;
+	identical = bench<game_variant<5, 8>>(best) && identical;
+	identical = bench<game_variant<6, 10>>(best) && identical;
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "combination.hpp"
+#include "clues_table.hpp"
+#include "packed_combination.hpp"
+
+/*
+ * Host benchmark of the clues computation: scores every guess against every
+ * secret, with the previous nested loops of combination::compute_clues, with
+ * the constexpr lookup table when the variant enables it, and with the SWAR
+ * packed combinations, and checks that they all agree.
+ */
+
+#define SLOT_USED 0xFF
+// Number of guesses scored against the whole code space, for the large variants
+#define BENCH_GUESS_MAX 2048
+
+// Two passes algorithm previously used by combination::compute_clues. Exact
+// matches are now tracked apart from the code slots, and the code slots are
+// consumed when counted as present: the previous loop counted the same code
+// slot several times when the guess repeated a color.
+template <class V>
+static uint8_t score_loop(const etl::array<uint8_t, V::SLOT_NB> &guess, etl::array<uint8_t, V::SLOT_NB> code)
+{
+	uint8_t correct = 0;
+	uint8_t present = 0;
+	etl::array<bool, V::SLOT_NB> matched = {};
+
+	for (uint8_t i = 0; i < code.size(); i++)
+	{
+		if (code[i] == guess[i])
+		{
+			correct++;
+			matched[i] = true;
+			code[i] = SLOT_USED;
+		}
+	}
+
+	for (uint8_t i = 0; i < code.size(); i++)
+	{
+		if (matched[i])
+		{
+			continue;
+		}
+
+		for (uint8_t j = 0; j < guess.size(); j++)
+		{
+			if (code[j] == guess[i])
+			{
+				present++;
+				code[j] = SLOT_USED;
+				break;
+			}
+		}
+	}
+
+	return V::clues_pack(correct, present);
+}
+
+template <class V>
+static constexpr uint32_t guess_nb = V::CODE_NB < BENCH_GUESS_MAX ? V::CODE_NB : BENCH_GUESS_MAX;
+
+template <class V, typename F>
+static double measure(const char *name, F score, uint32_t &checksum)
+{
+	auto start = std::chrono::steady_clock::now();
+	checksum = 0;
+
+	for (uint32_t guess = 0; guess < guess_nb<V>; guess++)
+	{
+		for (uint32_t secret = 0; secret < V::CODE_NB; secret++)
+		{
+			checksum += score(guess, secret);
+		}
+	}
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	double per_score = elapsed.count() / (double(guess_nb<V>) * V::CODE_NB);
+	printf("  %-8s %10.2f ms %8.2f ns/score (checksum %u)\n", name, elapsed.count() / 1e6, per_score, checksum);
+	return per_score;
+}
+
+template <class V>
+static bool bench(void)
+{
+	using packed_t = basic_packed_combination<V>;
+	std::vector<etl::array<uint8_t, V::SLOT_NB>> codes(V::CODE_NB);
+	std::vector<packed_t> packed(V::CODE_NB);
+	std::vector<typename packed_t::histogram_t> histograms(V::CODE_NB);
+	uint32_t checksum_loop;
+	uint32_t checksum;
+	bool ok = true;
+
+	printf("Variant %u slots x %u colors: scoring %u x %u combinations\n",
+		   V::SLOT_NB, V::COLOR_NB, guess_nb<V>, V::CODE_NB);
+
+	for (uint32_t i = 0; i < V::CODE_NB; i++)
+	{
+		for (uint8_t j = 0; j < V::SLOT_NB; j++)
+		{
+			codes[i][j] = V::digit(i, j);
+		}
+		packed[i] = packed_t::from_index(i);
+		histograms[i] = packed[i].histogram();
+	}
+
+	// Check the packed scoring against the loop before timing
+	for (uint32_t guess = 0; guess < guess_nb<V>; guess++)
+	{
+		for (uint32_t secret = 0; secret < V::CODE_NB; secret++)
+		{
+			uint8_t expected = score_loop<V>(codes[guess], codes[secret]);
+			if (expected != packed[guess].score(packed[secret]) || expected != clues_score<V>(guess, secret))
+			{
+				printf("Mismatch for guess %u and secret %u\n", guess, secret);
+				return false;
+			}
+		}
+	}
+
+	double loop = measure<V>("loop", [&](uint32_t g, uint32_t s)
+							 { return score_loop<V>(codes[g], codes[s]); }, checksum_loop);
+	if constexpr (clues_table<V>::ENABLED)
+	{
+		double table = measure<V>("table", [](uint32_t g, uint32_t s)
+								  { return clues_lookup<V>.score(g, s); }, checksum);
+		printf("  table speedup %.2fx, %zu bytes of flash\n", loop / table, clues_table<V>::SIZE);
+		ok = ok && checksum == checksum_loop;
+	}
+	double swar = measure<V>("swar", [&](uint32_t g, uint32_t s)
+							 { return packed[g].score(packed[s], histograms[g], histograms[s]); }, checksum);
+	printf("  swar speedup %.2fx, %zu bytes per packed combination\n", loop / swar, sizeof(packed_t));
+
+	return ok && checksum == checksum_loop;
+}
+
+int main(void)
+{
+	bool ok = bench<game_variant<4, 6>>();
+	ok = bench<game_variant<5, 8>>() && ok;
+	printf("Size: combination %zu bytes, packed tentative %zu bytes\n", sizeof(combination), sizeof(packed_tentative));
+
+	return ok ? 0 : 1;
+}
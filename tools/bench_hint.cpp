@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "etl/array.h"
+#include "game_variant.hpp"
+#include "candidate_set.hpp"
+#include "solver.hpp"
+#include "symmetry.hpp"
+
+/*
+ * Host benchmark of the hint latency by game depth: plays the solver against
+ * every secret and times each search, the depth being the number of
+ * tentatives already played. The minimax and entropy strategies are compared
+ * on their number of guesses and their latency per move.
+ *
+ * Each search is run twice, with and without the symmetry reduction, which
+ * must give the same guesses.
+ */
+
+#define DEPTH_MAX 16
+
+struct depth_stats
+{
+	uint32_t hints;
+	double total_ms;
+	double max_ms;
+	double symmetry_ms;
+	uint64_t classes;
+	uint64_t candidates;
+};
+
+template <class V>
+static void bench(solver_strategy strategy, const char *name)
+{
+	using clock = std::chrono::steady_clock;
+	etl::array<depth_stats, DEPTH_MAX> stats = {};
+	etl::array<uint32_t, DEPTH_MAX + 1> guesses = {};
+	uint64_t guesses_total = 0;
+	uint32_t mismatches = 0;
+
+	double total_ms = 0;
+	uint64_t hints = 0;
+
+	printf("Variant %u slots x %u colors, %u secrets, %s\n", V::SLOT_NB, V::COLOR_NB, V::CODE_NB, name);
+
+	for (uint32_t secret = 0; secret < V::CODE_NB; secret++)
+	{
+		basic_candidate_set<V> candidates;
+		basic_symmetry<V> history;
+		uint8_t depth = 0;
+
+		while (depth < DEPTH_MAX)
+		{
+			auto start = clock::now();
+			solver_result hint = basic_solver<V>::search(strategy, candidates, solver_budget::unlimited());
+			std::chrono::duration<double, std::milli> elapsed = clock::now() - start;
+
+			start = clock::now();
+			solver_result reduced = basic_solver<V>::search(strategy, candidates, solver_budget::unlimited(), &history);
+			std::chrono::duration<double, std::milli> reduced_elapsed = clock::now() - start;
+			if (reduced.guess != hint.guess || reduced.worst != hint.worst)
+			{
+				mismatches++;
+			}
+			stats[depth].symmetry_ms += reduced_elapsed.count();
+			for (uint32_t guess = 0; guess < V::CODE_NB; guess++)
+			{
+				stats[depth].classes += history.canonical(guess);
+			}
+
+			stats[depth].hints++;
+			stats[depth].total_ms += elapsed.count();
+			stats[depth].candidates += candidates.count();
+			if (elapsed.count() > stats[depth].max_ms)
+			{
+				stats[depth].max_ms = elapsed.count();
+			}
+
+			uint8_t clues = clues_score<V>(hint.guess, secret);
+			depth++;
+			if (clues == V::CLUES_WIN)
+			{
+				break;
+			}
+			candidates.prune(hint.guess, clues);
+			history.add(hint.guess);
+		}
+
+		guesses[depth]++;
+		guesses_total += depth;
+	}
+
+	for (uint8_t depth = 0; depth < DEPTH_MAX; depth++)
+	{
+		total_ms += stats[depth].total_ms;
+		hints += stats[depth].hints;
+	}
+
+	printf("  depth  hints  candidates    mean ms     max ms    classes  symmetry ms\n");
+	for (uint8_t depth = 0; depth < DEPTH_MAX && stats[depth].hints; depth++)
+	{
+		printf("  %5u %6u %11.1f %10.3f %10.3f %10.1f %12.3f\n", depth, stats[depth].hints,
+			   double(stats[depth].candidates) / stats[depth].hints,
+			   stats[depth].total_ms / stats[depth].hints, stats[depth].max_ms,
+			   double(stats[depth].classes) / stats[depth].hints, stats[depth].symmetry_ms / stats[depth].hints);
+	}
+
+	printf("  guesses:");
+	for (uint8_t depth = 1; depth <= DEPTH_MAX; depth++)
+	{
+		if (guesses[depth])
+		{
+			printf(" %u:%u", depth, guesses[depth]);
+		}
+	}
+	printf(", average %.4f\n", double(guesses_total) / V::CODE_NB);
+	printf("  %.3f ms per move without the symmetry reduction\n", total_ms / hints);
+	printf("  %u guesses differ with the symmetry reduction\n", mismatches);
+}
+
+int main(void)
+{
+	bench<game_variant<4, 6>>(solver_strategy::SOLVER_MINIMAX, "minimax");
+	bench<game_variant<4, 6>>(solver_strategy::SOLVER_ENTROPY, "entropy");
+
+	return 0;
+}
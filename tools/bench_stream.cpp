@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "game_variant.hpp"
+#include "solver.hpp"
+#include "stream_set.hpp"
+
+/*
+ * Host benchmark of the streaming candidate set on growing variants: plays a
+ * game against a pseudo-random secret, and reports for each guess the time
+ * spent choosing it and pruning the candidates, and the memory used.
+ *
+ * The first guess is the opening of the solver. The next ones are chosen by a
+ * sampled minimax: SAMPLE_NB candidates spread over the set are partitioned,
+ * and the one with the smallest largest partition is played. Every partition
+ * and prune is a parallel scan of the whole set.
+ *
+ * Usage: bench_stream [threads] [variant...]
+ *   variant: 4x6, 5x8, 6x10, 7x10 or 8x12, all of them by default
+ */
+
+#define SAMPLE_NB 8
+#define GUESS_MAX 32
+
+template <class V>
+static void bench(uint32_t thread_nb)
+{
+	using clock = std::chrono::steady_clock;
+	stream_set<V> candidates(thread_nb);
+	uint64_t partitions[V::CLUES_NB];
+	uint32_t secret = uint32_t(uint64_t(V::CODE_NB) * 7 / 13);
+
+	printf("Variant %u slots x %u colors, %u codes, %u containers, %u threads, %s kernel\n", V::SLOT_NB,
+		   V::COLOR_NB, V::CODE_NB, stream_set<V>::CONTAINER_NB, thread_nb, batch_isa_name(candidates.kernel()));
+	printf("  guess  candidates  choose ms   prune ms   memory KiB\n");
+
+	for (uint8_t g = 1; g <= GUESS_MAX; g++)
+	{
+		auto start = clock::now();
+		uint64_t count = candidates.count();
+		uint32_t guess = candidates.select(0);
+
+		if (count == V::CODE_NB)
+		{
+			guess = basic_solver<V>::opening();
+		}
+		else if (count > 2)
+		{
+			uint64_t best = UINT64_MAX;
+			for (uint32_t s = 0; s < SAMPLE_NB && s < count; s++)
+			{
+				uint32_t sample = candidates.select(count * s / SAMPLE_NB);
+				uint64_t worst = candidates.partition(sample, partitions);
+				if (worst < best)
+				{
+					best = worst;
+					guess = sample;
+				}
+			}
+		}
+		std::chrono::duration<double, std::milli> choose = clock::now() - start;
+
+		uint8_t clues = clues_score<V>(guess, secret);
+		start = clock::now();
+		if (clues != V::CLUES_WIN)
+		{
+			candidates.prune(guess, clues);
+		}
+		std::chrono::duration<double, std::milli> prune = clock::now() - start;
+
+		printf("  %5u %11lu %10.1f %10.1f %12.1f\n", g, (unsigned long)count, choose.count(), prune.count(),
+			   candidates.memory() / 1024.0);
+		if (clues == V::CLUES_WIN)
+		{
+			break;
+		}
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	printf("  containers high-water %.1f KiB, process high-water %ld KiB\n", candidates.memory_max() / 1024.0,
+		   usage.ru_maxrss);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t thread_nb = argc > 1 ? atoi(argv[1]) : 0;
+	if (thread_nb == 0)
+	{
+		thread_nb = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+	}
+
+	for (int i = 2; i < argc || (argc <= 2 && i == 2); i++)
+	{
+		const char *variant = argc > 2 ? argv[i] : nullptr;
+
+		if (!variant || !strcmp(variant, "4x6"))
+		{
+			bench<game_variant<4, 6>>(thread_nb);
+		}
+		if (!variant || !strcmp(variant, "5x8"))
+		{
+			bench<game_variant<5, 8>>(thread_nb);
+		}
+		if (!variant || !strcmp(variant, "6x10"))
+		{
+			bench<game_variant<6, 10>>(thread_nb);
+		}
+		if (!variant || !strcmp(variant, "7x10"))
+		{
+			bench<game_variant<7, 10>>(thread_nb);
+		}
+		if (!variant || !strcmp(variant, "8x12"))
+		{
+			bench<game_variant<8, 12>>(thread_nb);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,333 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "game_variant.hpp"
+#include "candidate_set.hpp"
+#include "solver.hpp"
+#include "partition_cache.hpp"
+#include "symmetry.hpp"
+#include "endgame.hpp"
+
+/*
+ * Host strategy evaluator: plays a strategy against every secret of a variant,
+ * or against an evenly spaced sample of them, and reports the distribution of
+ * the number of guesses.
+ *
+ * Games are split in chunks of secrets spread over per-thread deques. Each
+ * thread pops its own chunks from the back, and steals chunks from the front
+ * of a random other deque when its own is empty, so the load stays balanced
+ * even though the games of a strategy have very different costs.
+ *
+ * Usage: eval_strategy <variant> <strategy> [threads] [sample]
+ *   threads: 0 or absent for one thread per core
+ *   sample: number of secrets to play, 0 or absent for all of them
+ *   variant: 4x6, 5x8, 6x8 or 7x8
+ *   strategy: minimax (Knuth), entropy (largest information gain), endgame
+ *   (minimax, then the exact endgame solver from ENDGAME_CANDIDATE_MAX
+ *   candidates) or first (first consistent candidate)
+ *
+ * Each thread runs the solver through its own partition cache, and with the
+ * symmetry reduction of the game history.
+ */
+
+#define GUESS_MAX 32
+#define CHUNK_SIZE 16
+// Entries of the partition cache of each thread
+#define CACHE_SIZE 4096
+
+enum class strategy
+{
+	STRATEGY_MINIMAX,
+	STRATEGY_ENTROPY,
+	STRATEGY_ENDGAME,
+	STRATEGY_FIRST,
+};
+
+struct chunk
+{
+	uint32_t begin;
+	uint32_t end;
+};
+
+// Aligned on cache lines, so the counters of the threads do not share any
+struct alignas(64) worker
+{
+	std::mutex lock;
+	std::deque<chunk> chunks;
+	uint64_t games;
+	uint64_t steals;
+	double busy_s;
+	partition_cache_stats cache;
+	etl::array<uint64_t, GUESS_MAX + 1> guesses;
+};
+
+// Solvers and their working memory, one per thread
+template <class V>
+struct eval_solvers
+{
+	basic_partition_cache<V, CACHE_SIZE> cache;
+	basic_endgame<V, ENDGAME_CANDIDATE_MAX> exact;
+};
+
+template <class V>
+static uint32_t next_guess(strategy strat, const basic_candidate_set<V> &candidates, eval_solvers<V> &solvers,
+						   const basic_symmetry<V> &history)
+{
+	if (strat == strategy::STRATEGY_ENDGAME && candidates.count() <= ENDGAME_CANDIDATE_MAX)
+	{
+		return solvers.exact.solve(candidates, solver_budget::unlimited(), &history).guess;
+	}
+	if (strat == strategy::STRATEGY_ENTROPY)
+	{
+		return solvers.cache.search(solver_strategy::SOLVER_ENTROPY, candidates, solver_budget::unlimited(), &history)
+			.guess;
+	}
+	if (strat != strategy::STRATEGY_FIRST)
+	{
+		return solvers.cache.search(solver_strategy::SOLVER_MINIMAX, candidates, solver_budget::unlimited(), &history)
+			.guess;
+	}
+
+	return candidates.first();
+}
+
+/**
+ * @brief Play a game against a secret, and return the number of guesses.
+ */
+template <class V>
+static uint8_t play(strategy strat, uint32_t secret, basic_candidate_set<V> &candidates, eval_solvers<V> &solvers)
+{
+	basic_symmetry<V> history;
+	uint8_t guesses = 0;
+
+	candidates.reset();
+	while (guesses < GUESS_MAX)
+	{
+		uint32_t guess = next_guess<V>(strat, candidates, solvers, history);
+		uint8_t clues = clues_score<V>(guess, secret);
+
+		guesses++;
+		if (clues == V::CLUES_WIN)
+		{
+			break;
+		}
+		candidates.prune(guess, clues);
+		history.add(guess);
+	}
+
+	return guesses;
+}
+
+static bool pop(worker &self, chunk &task)
+{
+	std::lock_guard<std::mutex> guard(self.lock);
+
+	if (self.chunks.empty())
+	{
+		return false;
+	}
+	task = self.chunks.back();
+	self.chunks.pop_back();
+
+	return true;
+}
+
+static bool steal(std::vector<worker> &workers, size_t self, std::minstd_rand &rand, chunk &task)
+{
+	size_t start = rand() % workers.size();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		worker &victim = workers[(start + i) % workers.size()];
+		if (&victim == &workers[self])
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.chunks.empty())
+		{
+			task = victim.chunks.front();
+			victim.chunks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template <class V>
+static void run(std::vector<worker> &workers, size_t self, strategy strat, uint32_t stride)
+{
+	using clock = std::chrono::steady_clock;
+	worker &me = workers[self];
+	// Large variants have large candidate sets, keep them off the stack
+	auto candidates = std::make_unique<basic_candidate_set<V>>();
+	auto solvers = std::make_unique<eval_solvers<V>>();
+	std::minstd_rand rand(self + 1);
+	chunk task;
+
+	while (true)
+	{
+		if (!pop(me, task))
+		{
+			if (!steal(workers, self, rand, task))
+			{
+				// Chunks are never added back, so no work is left anywhere
+				break;
+			}
+			me.steals++;
+		}
+
+		auto start = clock::now();
+		for (uint32_t i = task.begin; i < task.end; i++)
+		{
+			me.guesses[play<V>(strat, i * stride, *candidates, *solvers)]++;
+			me.games++;
+		}
+		me.busy_s += std::chrono::duration<double>(clock::now() - start).count();
+	}
+	me.cache = solvers->cache.get_stats();
+}
+
+template <class V>
+static void evaluate(strategy strat, uint32_t thread_nb, uint32_t sample)
+{
+	using clock = std::chrono::steady_clock;
+	uint32_t game_nb = sample && sample < V::CODE_NB ? sample : V::CODE_NB;
+	uint32_t stride = V::CODE_NB / game_nb;
+	std::vector<worker> workers(thread_nb);
+	std::vector<std::thread> threads;
+
+	printf("Variant %u slots x %u colors, %u of %u secrets, %u threads\n", V::SLOT_NB, V::COLOR_NB, game_nb,
+		   V::CODE_NB, thread_nb);
+
+	// Deal the chunks round robin, so each thread starts with easy and hard games
+	for (uint32_t begin = 0, c = 0; begin < game_nb; begin += CHUNK_SIZE, c++)
+	{
+		uint32_t end = begin + CHUNK_SIZE < game_nb ? begin + CHUNK_SIZE : game_nb;
+		workers[c % thread_nb].chunks.push_back({begin, end});
+	}
+	for (auto &w : workers)
+	{
+		w.games = 0;
+		w.steals = 0;
+		w.busy_s = 0;
+		w.guesses.fill(0);
+	}
+
+	auto start = clock::now();
+	for (uint32_t t = 0; t < thread_nb; t++)
+	{
+		threads.emplace_back(run<V>, std::ref(workers), t, strat, stride);
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+	double wall_s = std::chrono::duration<double>(clock::now() - start).count();
+
+	etl::array<uint64_t, GUESS_MAX + 1> guesses = {};
+	uint64_t total = 0;
+	uint8_t worst = 0;
+	for (auto &w : workers)
+	{
+		for (uint8_t g = 0; g <= GUESS_MAX; g++)
+		{
+			guesses[g] += w.guesses[g];
+		}
+	}
+
+	printf("  guesses:");
+	for (uint8_t g = 0; g <= GUESS_MAX; g++)
+	{
+		if (guesses[g])
+		{
+			printf(" %u:%lu", g, (unsigned long)guesses[g]);
+			total += guesses[g] * g;
+			worst = g;
+		}
+	}
+	printf("\n  average %.4f, worst %u\n", double(total) / game_nb, worst);
+	printf("  %.3f s, %.1f games/s\n", wall_s, game_nb / wall_s);
+
+	printf("  thread    games  steals  utilization  cache hits  misses  evictions\n");
+	for (uint32_t t = 0; t < thread_nb; t++)
+	{
+		printf("  %6u %8lu %7lu %11.1f%% %11u %7u %10u\n", t, (unsigned long)workers[t].games,
+			   (unsigned long)workers[t].steals, 100 * workers[t].busy_s / wall_s, workers[t].cache.hits,
+			   workers[t].cache.misses, workers[t].cache.evictions);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <4x6|5x8|6x8|7x8> <minimax|entropy|endgame|first> [threads] [sample]\n", argv[0]);
+		return 1;
+	}
+
+	strategy strat;
+	if (!strcmp(argv[2], "minimax"))
+	{
+		strat = strategy::STRATEGY_MINIMAX;
+	}
+	else if (!strcmp(argv[2], "entropy"))
+	{
+		strat = strategy::STRATEGY_ENTROPY;
+	}
+	else if (!strcmp(argv[2], "endgame"))
+	{
+		strat = strategy::STRATEGY_ENDGAME;
+	}
+	else if (!strcmp(argv[2], "first"))
+	{
+		strat = strategy::STRATEGY_FIRST;
+	}
+	else
+	{
+		fprintf(stderr, "Unknown strategy %s\n", argv[2]);
+		return 1;
+	}
+
+	uint32_t thread_nb = argc > 3 ? atoi(argv[3]) : 0;
+	uint32_t sample = argc > 4 ? atoi(argv[4]) : 0;
+	if (thread_nb == 0)
+	{
+		thread_nb = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+	}
+
+	if (!strcmp(argv[1], "4x6"))
+	{
+		evaluate<game_variant<4, 6>>(strat, thread_nb, sample);
+	}
+	else if (!strcmp(argv[1], "5x8"))
+	{
+		evaluate<game_variant<5, 8>>(strat, thread_nb, sample);
+	}
+	else if (!strcmp(argv[1], "6x8"))
+	{
+		evaluate<game_variant<6, 8>>(strat, thread_nb, sample);
+	}
+	else if (!strcmp(argv[1], "7x8"))
+	{
+		evaluate<game_variant<7, 8>>(strat, thread_nb, sample);
+	}
+	else
+	{
+		fprintf(stderr, "Unknown variant %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,141 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "etl/array.h"
+#include "app_cfg.hpp"
+#include "game_variant.hpp"
+#include "candidate_set.hpp"
+#include "solver.hpp"
+
+/*
+ * Opening book generator: builds the minimax strategy tree of the configured
+ * variant and writes it as const tables included by src/opening_book.cpp.
+ *
+ * Nodes are stored in breadth-first order, so the children of a node are
+ * contiguous: the children of node n are the nodes children[n] to
+ * children[n + 1] - 1, each one reached by the clues stored in clues[]. The
+ * tree is cut after the given depth (0 for the full tree), the firmware falls
+ * back to the search below it. Nodes with one or two candidates are not stored,
+ * as the solver plays the first candidate without searching.
+ *
+ * Usage: gen_book <depth> <output file>
+ */
+
+#define OPENING_BOOK_VERSION 1
+
+struct book_node
+{
+	uint32_t guess;
+	uint8_t clues;
+	uint8_t depth;
+	candidate_set candidates;
+};
+
+static void write_table(FILE *file, const char *type, const char *name, const char *size,
+						const std::vector<uint32_t> &values)
+{
+	fprintf(file, "static const %s %s[%s] = {", type, name, size);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		fprintf(file, "%s%u,", i % 16 ? " " : "\n\t", values[i]);
+	}
+	fprintf(file, "\n};\n\n");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <depth> <output file>\n", argv[0]);
+		return 1;
+	}
+
+	uint8_t depth_max = atoi(argv[1]);
+	std::vector<book_node> nodes;
+	std::vector<uint32_t> guesses, children, clues;
+	etl::array<uint32_t, game::CLUES_NB> partitions;
+	uint64_t guesses_total = 0;
+	uint8_t guesses_max = 0;
+	bool complete = true;
+
+	nodes.push_back({0, 0, 1, candidate_set()});
+	for (size_t n = 0; n < nodes.size(); n++)
+	{
+		// Copy, as adding the children may reallocate the nodes
+		book_node node = nodes[n];
+
+		node.guess = solver::minimax(node.candidates, solver_budget::unlimited()).guess;
+		guesses.push_back(node.guess);
+		clues.push_back(node.clues);
+		children.push_back(nodes.size());
+
+		solver::partition(node.guess, node.candidates, partitions, UINT32_MAX);
+		if (partitions[game::CLUES_WIN])
+		{
+			guesses_total += node.depth;
+			guesses_max = node.depth > guesses_max ? node.depth : guesses_max;
+		}
+
+		for (uint8_t c = 0; c < game::CLUES_NB; c++)
+		{
+			if (c == game::CLUES_WIN || partitions[c] == 0)
+			{
+				continue;
+			}
+			if (partitions[c] <= 2)
+			{
+				// The solver plays the first candidate without any search
+				guesses_total += partitions[c] == 1 ? node.depth + 1 : 2 * node.depth + 3;
+				guesses_max = partitions[c] + node.depth > guesses_max ? partitions[c] + node.depth : guesses_max;
+				continue;
+			}
+			if (depth_max && node.depth >= depth_max)
+			{
+				complete = false;
+				break;
+			}
+
+			book_node child = {0, c, uint8_t(node.depth + 1), node.candidates};
+			child.candidates.prune(node.guess, c);
+			nodes.push_back(child);
+		}
+	}
+	children.push_back(nodes.size());
+
+	if (nodes.size() > UINT16_MAX)
+	{
+		fprintf(stderr, "%zu nodes do not fit the book, limit its depth\n", nodes.size());
+		return 1;
+	}
+
+	FILE *file = fopen(argv[2], "w");
+	if (!file)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	fprintf(file, "// Generated by tools/gen_book, do not edit\n\n");
+	fprintf(file, "#define OPENING_BOOK_VERSION %u\n", OPENING_BOOK_VERSION);
+	fprintf(file, "#define OPENING_BOOK_SLOT_NB %u\n", game::SLOT_NB);
+	fprintf(file, "#define OPENING_BOOK_COLOR_NB %u\n", game::COLOR_NB);
+	fprintf(file, "#define OPENING_BOOK_DEPTH %u\n", depth_max);
+	fprintf(file, "#define OPENING_BOOK_NODE_NB %zu\n\n", nodes.size());
+	write_table(file, sizeof(game::index_t) == 2 ? "uint16_t" : "uint32_t", "opening_book_guesses",
+				"OPENING_BOOK_NODE_NB", guesses);
+	write_table(file, "uint16_t", "opening_book_children", "OPENING_BOOK_NODE_NB + 1", children);
+	write_table(file, "uint8_t", "opening_book_clues", "OPENING_BOOK_NODE_NB", clues);
+	fclose(file);
+
+	printf("Opening book %u slots x %u colors: %zu nodes, %zu bytes of flash\n", game::SLOT_NB, game::COLOR_NB,
+		   nodes.size(), nodes.size() * (sizeof(game::index_t) + sizeof(uint16_t) + sizeof(uint8_t)) + sizeof(uint16_t));
+	if (complete)
+	{
+		printf("All secrets solved: average %.4f guesses, %u at most\n", double(guesses_total) / game::CODE_NB,
+			   guesses_max);
+	}
+
+	return 0;
+}
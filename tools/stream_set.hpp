@@ -0,0 +1,370 @@
+#ifndef STREAM_SET_H
+#define STREAM_SET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "game_variant.hpp"
+#include "packed_combination.hpp"
+#include "batch_score.hpp"
+
+/*
+ * Host candidate set for variants whose code space does not fit in a bitset,
+ * such as 6x10 (one million codes) or 8x12 (430 million codes).
+ *
+ * Like a Roaring bitmap, the code space is split in containers of 65536
+ * indexes, each one stored in the smallest of four forms:
+ * - empty or full, without any storage, which is how the set starts
+ * - a sorted array of the low 16 bits of the indexes, up to ARRAY_MAX entries
+ * - a bitmap of 8 KiB
+ *
+ * Scans stream the candidates of each container in chunks of CHUNK_SIZE
+ * packed combinations through the batch scoring kernel. Containers are
+ * independent, so they are shared between threads with an atomic counter.
+ * The memory used by the containers is accounted, with its high-water mark.
+ */
+
+template <class V>
+class stream_set
+{
+public:
+	static constexpr uint32_t CONTAINER_BITS = 16;
+	static constexpr uint32_t CONTAINER_SIZE = uint32_t(1) << CONTAINER_BITS;
+	static constexpr uint32_t CONTAINER_NB = (uint64_t(V::CODE_NB) + CONTAINER_SIZE - 1) / CONTAINER_SIZE;
+	// An array of uint16_t is smaller than a bitmap up to 4096 entries
+	static constexpr uint32_t ARRAY_MAX = CONTAINER_SIZE / 16;
+	static constexpr uint32_t BITMAP_WORDS = CONTAINER_SIZE / 64;
+	static constexpr uint32_t CHUNK_SIZE = 1024;
+
+	explicit stream_set(uint32_t thread_nb)
+		: containers(CONTAINER_NB), thread_nb(thread_nb ? thread_nb : 1), isa(batch_isa_detect()), bytes(0),
+		  bytes_max(0)
+	{
+		reset();
+	}
+
+	/**
+	 * @brief Mark all the combinations as candidates.
+	 */
+	void reset(void)
+	{
+		for (uint32_t key = 0; key < CONTAINER_NB; key++)
+		{
+			store(key, container_type::CONTAINER_FULL, range(key), {}, {});
+		}
+	}
+
+	/**
+	 * @brief Remove the candidates which would not give the same clues to the guess.
+	 *
+	 * @return The number of candidates left
+	 */
+	uint64_t prune(uint32_t guess, uint8_t clues)
+	{
+		parallel([&](uint32_t key, scratch &work) { prune_container(key, guess, clues, work); });
+
+		return count();
+	}
+
+	/**
+	 * @brief Count the candidates for each clues given to the guess.
+	 *
+	 * @param partitions Number of candidates for each packed clues, V::CLUES_NB entries
+	 *
+	 * @return The size of the largest partition
+	 */
+	uint64_t partition(uint32_t guess, uint64_t *partitions)
+	{
+		std::vector<scratch> works = parallel([&](uint32_t key, scratch &work) {
+			batch_score<V> scorer(guess);
+			for_each_chunk(key, work, [&](size_t n) {
+				scorer.run(isa, work.packed.data(), n, work.histogram.data(), nullptr);
+			});
+		});
+
+		uint64_t worst = 0;
+		for (uint8_t c = 0; c < V::CLUES_NB; c++)
+		{
+			partitions[c] = 0;
+			for (auto &work : works)
+			{
+				partitions[c] += work.histogram[c];
+			}
+			worst = partitions[c] > worst ? partitions[c] : worst;
+		}
+
+		return worst;
+	}
+
+	uint64_t count(void) const
+	{
+		uint64_t total = 0;
+
+		for (auto &cont : containers)
+		{
+			total += cont.cardinality;
+		}
+
+		return total;
+	}
+
+	/**
+	 * @brief Get the candidate of the given rank, in index order.
+	 */
+	uint32_t select(uint64_t rank) const
+	{
+		for (uint32_t key = 0; key < CONTAINER_NB; key++)
+		{
+			const container &cont = containers[key];
+			if (rank >= cont.cardinality)
+			{
+				rank -= cont.cardinality;
+				continue;
+			}
+
+			uint32_t base = key << CONTAINER_BITS;
+			switch (cont.type)
+			{
+			case container_type::CONTAINER_FULL:
+				return base + rank;
+			case container_type::CONTAINER_ARRAY:
+				return base + cont.array[rank];
+			default:
+				for (uint32_t w = 0; w < BITMAP_WORDS; w++)
+				{
+					uint32_t bits = __builtin_popcountll(cont.bitmap[w]);
+					if (rank < bits)
+					{
+						uint64_t word = cont.bitmap[w];
+						for (; rank; rank--)
+						{
+							word &= word - 1;
+						}
+						return base + w * 64 + __builtin_ctzll(word);
+					}
+					rank -= bits;
+				}
+			}
+		}
+
+		return V::CODE_NB;
+	}
+
+	// Memory used by the containers, in bytes
+	size_t memory(void) const
+	{
+		return bytes;
+	}
+
+	size_t memory_max(void) const
+	{
+		return bytes_max;
+	}
+
+	batch_isa kernel(void) const
+	{
+		return isa;
+	}
+
+private:
+	enum class container_type
+	{
+		CONTAINER_EMPTY,
+		CONTAINER_FULL,
+		CONTAINER_ARRAY,
+		CONTAINER_BITMAP,
+	};
+
+	struct container
+	{
+		container_type type = container_type::CONTAINER_EMPTY;
+		uint32_t cardinality = 0;
+		std::vector<uint16_t> array;
+		std::vector<uint64_t> bitmap;
+	};
+
+	// Per thread buffers, allocated once per scan
+	struct scratch
+	{
+		std::vector<uint32_t> indexes;
+		std::vector<uint32_t> packed;
+		std::vector<uint8_t> clues;
+		std::vector<uint32_t> histogram;
+		std::vector<uint16_t> kept;
+	};
+
+	std::vector<container> containers;
+	uint32_t thread_nb;
+	batch_isa isa;
+	std::atomic<size_t> bytes;
+	std::atomic<size_t> bytes_max;
+
+	static uint32_t range(uint32_t key)
+	{
+		uint64_t end = uint64_t(key + 1) << CONTAINER_BITS;
+
+		return (end > V::CODE_NB ? V::CODE_NB : end) - (uint64_t(key) << CONTAINER_BITS);
+	}
+
+	void store(uint32_t key, container_type type, uint32_t cardinality, std::vector<uint16_t> array,
+			   std::vector<uint64_t> bitmap)
+	{
+		container &cont = containers[key];
+		size_t before = cont.array.capacity() * sizeof(uint16_t) + cont.bitmap.capacity() * sizeof(uint64_t);
+		size_t after = array.capacity() * sizeof(uint16_t) + bitmap.capacity() * sizeof(uint64_t);
+
+		// Account the new container before freeing the old one, as both exist at that time
+		size_t peak = bytes.fetch_add(after) + after;
+		size_t max = bytes_max.load();
+		while (peak > max && !bytes_max.compare_exchange_weak(max, peak))
+		{
+		}
+
+		cont.type = type;
+		cont.cardinality = cardinality;
+		cont.array = std::move(array);
+		cont.bitmap = std::move(bitmap);
+		bytes.fetch_sub(before);
+	}
+
+	/**
+	 * @brief Run a function on every non empty container, spread over the threads.
+	 *
+	 * @return The scratch buffers of each thread
+	 */
+	template <typename F>
+	std::vector<scratch> parallel(F function)
+	{
+		std::atomic<uint32_t> next(0);
+		std::vector<scratch> works(thread_nb);
+		std::vector<std::thread> threads;
+
+		for (uint32_t t = 0; t < thread_nb; t++)
+		{
+			threads.emplace_back([&, t]() {
+				scratch &work = works[t];
+				work.indexes.resize(CHUNK_SIZE);
+				work.packed.resize(CHUNK_SIZE);
+				work.clues.resize(CHUNK_SIZE);
+				work.histogram.assign(V::CLUES_NB, 0);
+
+				for (uint32_t key = next++; key < CONTAINER_NB; key = next++)
+				{
+					if (containers[key].cardinality)
+					{
+						function(key, work);
+					}
+				}
+			});
+		}
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		return works;
+	}
+
+	/**
+	 * @brief Stream the candidates of a container in chunks of packed combinations.
+	 *
+	 * The function is called with the number of candidates of each chunk,
+	 * stored in the indexes and packed buffers of the scratch.
+	 */
+	template <typename F>
+	void for_each_chunk(uint32_t key, scratch &work, F function) const
+	{
+		const container &cont = containers[key];
+		uint32_t base = key << CONTAINER_BITS;
+		size_t n = 0;
+
+		auto add = [&](uint32_t index) {
+			work.indexes[n] = index;
+			work.packed[n++] = basic_packed_combination<V>::from_index(index).bits;
+			if (n == CHUNK_SIZE)
+			{
+				function(n);
+				n = 0;
+			}
+		};
+
+		switch (cont.type)
+		{
+		case container_type::CONTAINER_FULL:
+			for (uint32_t i = 0; i < cont.cardinality; i++)
+			{
+				add(base + i);
+			}
+			break;
+		case container_type::CONTAINER_ARRAY:
+			for (uint16_t low : cont.array)
+			{
+				add(base + low);
+			}
+			break;
+		case container_type::CONTAINER_BITMAP:
+			for (uint32_t w = 0; w < BITMAP_WORDS; w++)
+			{
+				uint64_t word = cont.bitmap[w];
+				while (word)
+				{
+					add(base + w * 64 + __builtin_ctzll(word));
+					word &= word - 1;
+				}
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (n)
+		{
+			function(n);
+		}
+	}
+
+	void prune_container(uint32_t key, uint32_t guess, uint8_t clues, scratch &work)
+	{
+		batch_score<V> scorer(guess);
+
+		work.kept.clear();
+		for_each_chunk(key, work, [&](size_t n) {
+			scorer.run(isa, work.packed.data(), n, work.histogram.data(), work.clues.data());
+			for (size_t i = 0; i < n; i++)
+			{
+				if (work.clues[i] == clues)
+				{
+					work.kept.push_back(work.indexes[i] & (CONTAINER_SIZE - 1));
+				}
+			}
+		});
+
+		uint32_t kept = work.kept.size();
+		if (kept == 0)
+		{
+			store(key, container_type::CONTAINER_EMPTY, 0, {}, {});
+		}
+		else if (kept == range(key))
+		{
+			store(key, container_type::CONTAINER_FULL, kept, {}, {});
+		}
+		else if (kept <= ARRAY_MAX)
+		{
+			store(key, container_type::CONTAINER_ARRAY, kept, std::vector<uint16_t>(work.kept), {});
+		}
+		else
+		{
+			std::vector<uint64_t> bitmap(BITMAP_WORDS);
+			for (uint16_t low : work.kept)
+			{
+				bitmap[low / 64] |= uint64_t(1) << (low % 64);
+			}
+			store(key, container_type::CONTAINER_BITMAP, kept, {}, std::move(bitmap));
+		}
+	}
+};
+
+#endif